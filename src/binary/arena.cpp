@@ -0,0 +1,79 @@
+
+#include "arena.hpp"
+
+void SectionArena::expand(size_t bytes) {
+
+	// reuse chunks left over from before `clear()`
+	while (current + 1 < chunks.size()) {
+		current ++;
+
+		if (chunks[current].size >= bytes) {
+			this->head = 0;
+			return;
+		}
+	}
+
+	size_t size = std::max(bytes, chunk_size);
+
+	chunks.push_back({std::make_unique_for_overwrite<uint8_t[]>(size), size});
+	allocations ++;
+
+	this->current = chunks.size() - 1;
+	this->head = 0;
+}
+
+void* SectionArena::allocate(size_t bytes, size_t align) {
+
+	if (!chunks.empty()) {
+		Chunk& chunk = chunks[current];
+		uintptr_t base = (uintptr_t) chunk.data.get();
+		size_t start = ((base + head + align - 1) & ~(align - 1)) - base;
+
+		if (start + bytes <= chunk.size) {
+			this->head = start + bytes;
+			return chunk.data.get() + start;
+		}
+	}
+
+	// the new chunk is aligned to at least max_align_t, for
+	// larger alignments we need to reserve some more space
+	expand(bytes + (align > alignof(std::max_align_t) ? align : 0));
+	return allocate(bytes, align);
+}
+
+void* SectionArena::block(size_t bytes) {
+	size_t size = std::bit_ceil(std::max(bytes, sizeof(void*)));
+	void*& head = released[std::countr_zero(size)];
+
+	if (head) {
+		void* block = head;
+		head = *static_cast<void**>(block);
+		return block;
+	}
+
+	return allocate(size);
+}
+
+void SectionArena::release(void* block, size_t bytes) {
+	if (block == nullptr) {
+		return;
+	}
+
+	size_t size = std::bit_ceil(std::max(bytes, sizeof(void*)));
+	void*& head = released[std::countr_zero(size)];
+
+	*static_cast<void**>(block) = head;
+	head = block;
+}
+
+void SectionArena::clear() {
+	this->current = 0;
+	this->head = 0;
+	this->allocations = 0;
+
+	std::fill(std::begin(released), std::end(released), nullptr);
+}
+
+int SectionArena::count() const {
+	return allocations;
+}
@@ -0,0 +1,63 @@
+
+#pragma once
+#include <common/external.hpp>
+
+class SectionArena {
+
+	private:
+
+		struct Chunk {
+			std::unique_ptr<uint8_t[]> data;
+			size_t size;
+		};
+
+		// chunks are never moved or freed before the arena is destroyed
+		// so pointers returned from `allocate()` stay valid, after `clear()`
+		// the existing chunks are reused in order before allocating new ones
+		std::vector<Chunk> chunks;
+		size_t current = 0;
+		size_t head = 0;
+
+		// the number of heap allocations made by this arena
+		int allocations = 0;
+
+		// released blocks, indexed by the log2 of the block size,
+		// the link to the next free block is stored in the block itself
+		void* released[64] = {};
+
+		static constexpr size_t chunk_size = 64 * 1024;
+
+		/// allocates a new chunk that can fit at least `bytes` bytes
+		void expand(size_t bytes);
+
+	public:
+
+		/// bump allocate `bytes` bytes aligned to `align` (must be a power of two)
+		void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+
+		/// allocates a block of at least `bytes` bytes, rounded up to a power of two, reusing a released block if possible
+		void* block(size_t bytes);
+
+		/// returns a block obtained from `block()` to the arena, so that it can be reused by the next call
+		void release(void* block, size_t bytes);
+
+		/// marks all memory as unused without freeing it, all previously returned pointers become invalid
+		void clear();
+
+		/// returns the number of heap allocations made since the arena was created or cleared
+		int count() const;
+
+	public:
+
+		template <typename T>
+		T* allocate(size_t count) {
+			return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+		}
+
+		template <typename T, typename... Args>
+		T* create(Args&&... args) {
+			static_assert(std::is_trivially_destructible_v<T>, "Arena objects are never destructed");
+			return new (allocate(sizeof(T), alignof(T))) T {std::forward<Args>(args)...};
+		}
+
+};
@@ -0,0 +1,127 @@
+
+#include "blocks.hpp"
+#include "header.hpp"
+#include "codec.hpp"
+
+BlockCache::BlockCache(const uint8_t* data, size_t size, size_t capacity, bool swapped)
+: file(data), capacity(capacity) {
+
+	if (size < BinaryTreeHeader::size + 4) {
+		throw std::runtime_error {"Block table is truncated"};
+	}
+
+	uint32_t count;
+	memcpy(&count, data + BinaryTreeHeader::size, 4);
+
+	if (swapped) {
+		count = ByteSwap::value(count);
+	}
+
+	if ((size - BinaryTreeHeader::size - 4) / BlockEntry::size < count) {
+		throw std::runtime_error {"Block table is truncated"};
+	}
+
+	const uint8_t* table = data + BinaryTreeHeader::size + 4;
+	blocks.resize(count);
+
+	for (uint32_t i = 0; i < count; i ++) {
+		BlockEntry& entry = blocks[i].entry;
+		memcpy(&entry, table + i * BlockEntry::size, BlockEntry::size);
+
+		if (swapped) {
+			ByteSwap::bulk(&entry, &entry, 4, 4);
+		}
+
+		if (entry.offset > size || entry.packed > size - entry.offset) {
+			throw std::runtime_error {"Block " + std::to_string(i) + " lies outside of the file"};
+		}
+
+		// the size is checked before anything gets allocated for the block
+		if (entry.length > BlockCodec::bound(entry.packed)) {
+			throw std::runtime_error {"Block " + std::to_string(i) + " is larger than its compressed data allows"};
+		}
+
+		if (i > 0 && entry.start < (uint64_t) blocks[i - 1].entry.start + blocks[i - 1].entry.length) {
+			throw std::runtime_error {"Block " + std::to_string(i) + " overlaps the previous block"};
+		}
+	}
+
+}
+
+void BlockCache::load(Block& block) {
+	constexpr size_t alignment = 64;
+
+	// offset the data so that it has the same alignment as it would have in an uncompressed file
+	block.memory = std::make_unique_for_overwrite<uint8_t[]>(block.entry.length + alignment);
+	uintptr_t base = (uintptr_t) block.memory.get();
+	size_t shift = (block.entry.start - base) & (alignment - 1);
+
+	uint8_t* data = block.memory.get() + shift;
+
+	if (!BlockCodec::decompress(file + block.entry.offset, block.entry.packed, data, block.entry.length)) {
+		block.memory.reset();
+		throw std::runtime_error {"Failed to decompress block at offset " + std::to_string(block.entry.offset)};
+	}
+
+	block.data = data;
+	loaded.push_back(&block);
+}
+
+BlockCache::Block* BlockCache::find(uint32_t offset) {
+
+	// find the last block starting at or before the offset
+	auto it = std::upper_bound(blocks.begin(), blocks.end(), offset, [] (uint32_t offset, const Block& block) {
+		return offset < block.entry.start;
+	});
+
+	if (it == blocks.begin()) {
+		return nullptr;
+	}
+
+	Block& block = *std::prev(it);
+
+	// empty sections can be placed just past the end of a block
+	if (offset - block.entry.start > block.entry.length) {
+		return nullptr;
+	}
+
+	return &block;
+}
+
+const uint8_t* BlockCache::resolve(uint32_t offset, uint8_t) {
+	Block* block = find(offset);
+
+	if (block == nullptr) {
+		throw std::runtime_error {"Offset " + std::to_string(offset) + " is not part of any block"};
+	}
+
+	if (block->data == nullptr) {
+		load(*block);
+	}
+
+	block->used = ++ clock;
+	return block->data + (offset - block->entry.start);
+}
+
+size_t BlockCache::extent(uint32_t offset, uint8_t) {
+	Block* block = find(offset);
+	return block ? block->entry.length - (offset - block->entry.start) : 0;
+}
+
+void BlockCache::trim() {
+	if (loaded.size() <= capacity) {
+		return;
+	}
+
+	// the most recently used blocks go first, the rest are released
+	std::sort(loaded.begin(), loaded.end(), [] (const Block* a, const Block* b) {
+		return a->used > b->used;
+	});
+
+	for (size_t i = capacity; i < loaded.size(); i ++) {
+		loaded[i]->memory.reset();
+		loaded[i]->data = nullptr;
+	}
+
+	loaded.resize(capacity);
+}
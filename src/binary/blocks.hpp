@@ -0,0 +1,69 @@
+
+#pragma once
+#include <common/external.hpp>
+
+#include "reader.hpp"
+
+/// one entry in the block table of a compressed file
+struct BlockEntry {
+
+	uint32_t start;  // offset of the first section in the block
+	uint32_t length; // uncompressed size of the block
+	uint32_t offset; // location of the compressed data within the file
+	uint32_t packed; // compressed size of the block
+
+	static constexpr size_t size = 16;
+
+};
+
+static_assert(sizeof(BlockEntry) == BlockEntry::size);
+
+/// resolves section offsets within a compressed file, blocks are decompressed on first access and kept
+/// until `trim()` is called, which drops the least recently used blocks, `BinaryTree::Input` calls it on
+/// each `root()` and `read()` and the validator after each section, so only a single long traversal
+/// of the nodes keeps all the blocks it visited loaded
+class BlockCache : public SectionSource {
+
+	private:
+
+		struct Block {
+			BlockEntry entry;
+			std::unique_ptr<uint8_t[]> memory;
+			const uint8_t* data = nullptr;
+			uint64_t used = 0;
+		};
+
+		const uint8_t* file;
+		std::vector<Block> blocks;
+
+		// the blocks that are decompressed, so that `trim()` doesn't need to look at all of
+		// them, it is called after every section during validation, so it needs to be cheap
+		std::vector<Block*> loaded;
+
+		size_t capacity;
+		uint64_t clock = 0;
+
+		/// decompresses the block, the data is placed so that it keeps its alignment within the file
+		void load(Block& block);
+
+		/// returns the block that contains the offset, or null if there is none
+		Block* find(uint32_t offset);
+
+	public:
+
+		/// reads the block table that follows the header, at most `capacity` blocks are kept after `trim()`,
+		/// `swapped` needs to be set if the table was written in the opposite byte order
+		BlockCache(const uint8_t* data, size_t size, size_t capacity = 16, bool swapped = false);
+
+		/// returns a pointer into the decompressed block that contains the offset, sections
+		/// never cross block boundaries, so the type of the section is not needed
+		const uint8_t* resolve(uint32_t offset, uint8_t type) override;
+
+		/// returns the number of bytes between the offset and the end of its block
+		size_t extent(uint32_t offset, uint8_t type) override;
+
+		/// drops the least recently used blocks over the capacity, this invalidates
+		/// all the readers and node views created from data in those blocks
+		void trim() override;
+
+};
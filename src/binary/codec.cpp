@@ -0,0 +1,142 @@
+
+#include "codec.hpp"
+
+void BlockCodec::length(std::vector<uint8_t>& output, size_t value) {
+	while (value >= 0xFF) {
+		output.push_back(0xFF);
+		value -= 0xFF;
+	}
+
+	output.push_back(value);
+}
+
+void BlockCodec::sequence(std::vector<uint8_t>& output, const uint8_t* from, size_t literals, size_t match, size_t distance) {
+	size_t extra = match ? match - min_match : 0;
+	output.push_back((std::min<size_t>(literals, 15) << 4) | std::min<size_t>(extra, 15));
+
+	if (literals >= 15) {
+		length(output, literals - 15);
+	}
+
+	output.insert(output.end(), from, from + literals);
+
+	// the last sequence contains only literals
+	if (match == 0) {
+		return;
+	}
+
+	output.push_back(distance & 0xFF);
+	output.push_back(distance >> 8);
+
+	if (extra >= 15) {
+		length(output, extra - 15);
+	}
+}
+
+void BlockCodec::compress(const uint8_t* input, size_t size, std::vector<uint8_t>& output) {
+
+	// positions are stored plus one, so that zero marks an empty slot
+	uint32_t table[1 << hash_bits] = {};
+	size_t anchor = 0;
+	size_t head = 0;
+
+	if (size > match_margin) {
+		size_t limit = size - match_margin;
+
+		while (head < limit) {
+			uint32_t word;
+			memcpy(&word, input + head, 4);
+
+			uint32_t hash = (word * 2654435761u) >> (32 - hash_bits);
+			size_t candidate = table[hash];
+			table[hash] = head + 1;
+
+			if (candidate == 0 || head + 1 - candidate > max_distance || memcmp(input + candidate - 1, input + head, min_match) != 0) {
+				head ++;
+				continue;
+			}
+
+			size_t from = candidate - 1;
+			size_t match = min_match;
+
+			while (head + match < size - tail_literals && input[from + match] == input[head + match]) {
+				match ++;
+			}
+
+			sequence(output, input + anchor, head - anchor, match, head - from);
+			head += match;
+			anchor = head;
+		}
+	}
+
+	sequence(output, input + anchor, size - anchor, 0, 0);
+}
+
+bool BlockCodec::decompress(const uint8_t* input, size_t size, uint8_t* output, size_t expected) {
+
+	const uint8_t* end = input + size;
+	uint8_t* head = output;
+	uint8_t* limit = output + expected;
+
+	// reads the extended length bytes, returns false on truncated input
+	auto extend = [&] (size_t& value) -> bool {
+		uint8_t byte;
+
+		do {
+			if (input >= end) return false;
+			byte = *input ++;
+			value += byte;
+		} while (byte == 0xFF);
+
+		return true;
+	};
+
+	while (input < end) {
+		uint8_t token = *input ++;
+		size_t literals = token >> 4;
+
+		if (literals == 15 && !extend(literals)) {
+			return false;
+		}
+
+		if ((size_t) (end - input) < literals || (size_t) (limit - head) < literals) {
+			return false;
+		}
+
+		memcpy(head, input, literals);
+		input += literals;
+		head += literals;
+
+		// the last sequence contains only literals
+		if (input == end) {
+			break;
+		}
+
+		if (end - input < 2) {
+			return false;
+		}
+
+		size_t distance = input[0] | (input[1] << 8);
+		size_t match = (token & 0x0F) + min_match;
+		input += 2;
+
+		if ((token & 0x0F) == 15 && !extend(match)) {
+			return false;
+		}
+
+		if (distance == 0 || distance > (size_t) (head - output) || (size_t) (limit - head) < match) {
+			return false;
+		}
+
+		// the ranges can overlap, so this needs to go byte by byte
+		const uint8_t* from = head - distance;
+
+		for (size_t i = 0; i < match; i ++) {
+			head[i] = from[i];
+		}
+
+		head += match;
+	}
+
+	return head == limit;
+}
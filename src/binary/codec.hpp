@@ -0,0 +1,40 @@
+
+#pragma once
+#include <common/external.hpp>
+
+/// a small self-contained LZ77 codec, uses the LZ4 block
+/// format (token, literals, 16 bit distance, match length)
+class BlockCodec {
+
+	private:
+
+		static constexpr size_t min_match = 4;
+		static constexpr size_t max_distance = 0xFFFF;
+
+		// the last literals of a block are never part of a match
+		static constexpr size_t tail_literals = 5;
+		static constexpr size_t match_margin = 12;
+
+		static constexpr int hash_bits = 12;
+
+		/// writes the extended length bytes used when a length doesn't fit into the token nibble
+		static void length(std::vector<uint8_t>& output, size_t value);
+
+		/// writes a single sequence, `literals` bytes starting at `from`, followed by an optional match
+		static void sequence(std::vector<uint8_t>& output, const uint8_t* from, size_t literals, size_t match, size_t distance);
+
+	public:
+
+		/// compresses `size` bytes from `input` appending the result to `output`
+		static void compress(const uint8_t* input, size_t size, std::vector<uint8_t>& output);
+
+		/// returns the largest size `size` compressed bytes can expand to, no byte
+		/// of the input (not even a run of extended length bytes) yields more than 255
+		static uint64_t bound(size_t size) {
+			return (uint64_t) size * 255;
+		}
+
+		/// decompresses exactly `expected` bytes into `output`, returns false if the input is malformed
+		static bool decompress(const uint8_t* input, size_t size, uint8_t* output, size_t expected);
+
+};
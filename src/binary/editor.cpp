@@ -0,0 +1,539 @@
+
+#include "editor.hpp"
+
+using Step = BinaryTreeQuery::Step;
+
+/// reads the value at the offset, throws if it lies outside of the file
+template <typename T>
+static T load(std::span<const uint8_t> data, uint64_t offset) {
+	if (offset + sizeof(T) > data.size()) {
+		throw std::runtime_error {"Offset " + std::to_string(offset) + " lies outside of the file"};
+	}
+
+	T value;
+	memcpy(&value, data.data() + offset, sizeof(T));
+	return value;
+}
+
+/// returns the bytes of the slot starting at the offset, that is the type byte followed by the payload
+static std::span<const uint8_t> slot(std::span<const uint8_t> data, uint64_t offset) {
+	uint32_t size = 1 + BinaryTreeNode::sizeOf(load<uint8_t>(data, offset));
+
+	if (offset + size > data.size()) {
+		throw std::runtime_error {"Offset " + std::to_string(offset) + " lies outside of the file"};
+	}
+
+	return data.subspan(offset, size);
+}
+
+template <typename T>
+static void store(std::vector<uint8_t>& output, T value) {
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+	output.insert(output.end(), bytes, bytes + sizeof(T));
+}
+
+/// appends the bytes to the output that will be placed at `base`, keeping the position of the `original`
+/// offset within a cache line, so that any alignment the section had is kept, returns the new offset
+static uint32_t place(std::vector<uint8_t>& output, uint32_t base, uint64_t original, std::span<const uint8_t> bytes) {
+	while ((base + output.size()) % 64 != original % 64) {
+		output.push_back(0);
+	}
+
+	uint32_t offset = base + output.size();
+	output.insert(output.end(), bytes.begin(), bytes.end());
+	return offset;
+}
+
+[[noreturn]] static void missing(const Step& step) {
+	throw std::runtime_error {"Unable to follow the path, " + std::string {step.kind == Step::KEY ? "key " : "index "} + std::to_string(step.value) + " was not found"};
+}
+
+/// returns the type and payload offset of the value selected by the step from the section
+static std::pair<uint8_t, uint64_t> child(std::span<const uint8_t> data, uint8_t type, uint32_t section, const Step& step, uint16_t flags) {
+
+	if (type == BinaryNode::DICT && (flags & BinaryFlag::INDEXED_DICTS)) {
+		uint8_t count = load<uint8_t>(data, section);
+
+		for (uint32_t i = 0; i < count; i ++) {
+			if (load<uint16_t>(data, section + 1 + i * 2) == step.value) {
+				uint64_t value = section + load<uint16_t>(data, section + 1 + (count + i) * 2);
+				return {load<uint8_t>(data, value), value + 1};
+			}
+		}
+
+		missing(step);
+	}
+
+	if (type == BinaryNode::DICT) {
+		uint8_t count = load<uint8_t>(data, section);
+		uint64_t entry = section + 1;
+
+		for (uint32_t i = 0; i < count; i ++) {
+			uint8_t node = load<uint8_t>(data, entry + 2);
+
+			if (load<uint16_t>(data, entry) == step.value) {
+				return {node, entry + 3};
+			}
+
+			entry += 3 + BinaryTreeNode::sizeOf(node);
+		}
+
+		missing(step);
+	}
+
+	if (type == BinaryNode::MAP) {
+		uint32_t count = load<uint32_t>(data, section);
+		uint32_t values = load<uint32_t>(data, section + 4);
+
+		// find the first record with the key, the records are sorted by key
+		uint32_t low = 0;
+		uint32_t high = count;
+
+		while (low < high) {
+			uint32_t middle = low + (high - low) / 2;
+
+			if (load<uint16_t>(data, section + 8 + (uint64_t) middle * 6) < step.value) {
+				low = middle + 1;
+			} else {
+				high = middle;
+			}
+		}
+
+		if (low == count || load<uint16_t>(data, section + 8 + (uint64_t) low * 6) != step.value) {
+			missing(step);
+		}
+
+		uint64_t value = (uint64_t) values + load<uint32_t>(data, section + 8 + (uint64_t) low * 6 + 2);
+		return {load<uint8_t>(data, value), value + 1};
+	}
+
+	uint32_t count = load<uint32_t>(data, section);
+	uint8_t node = load<uint8_t>(data, section + 4);
+
+	if (step.value >= count) {
+		missing(step);
+	}
+
+	return {node, section + 5 + (uint64_t) step.value * BinaryTreeNode::sizeOf(node)};
+}
+
+/// copies a dictionary section, with the value under the key replaced or added
+static std::vector<uint8_t> dict(std::span<const uint8_t> data, uint32_t section, uint16_t key, std::span<const uint8_t> value) {
+	uint8_t count = load<uint8_t>(data, section);
+	uint64_t entry = section + 1;
+	bool found = false;
+
+	std::vector<uint8_t> output {count};
+
+	for (uint32_t i = 0; i < count; i ++) {
+		uint16_t current = load<uint16_t>(data, entry);
+		std::span<const uint8_t> bytes = slot(data, entry + 2);
+
+		store<uint16_t>(output, current);
+
+		// only the first entry with the key is visible to readers
+		if (!found && current == key) {
+			output.insert(output.end(), value.begin(), value.end());
+			found = true;
+		} else {
+			output.insert(output.end(), bytes.begin(), bytes.end());
+		}
+
+		entry += 2 + bytes.size();
+	}
+
+	if (!found) {
+		if (count == 0xFF) {
+			throw std::runtime_error {"Unable to add another key, maximum dictionary capacity reached"};
+		}
+
+		store<uint16_t>(output, key);
+		output.insert(output.end(), value.begin(), value.end());
+		output[0] = count + 1;
+	}
+
+	return output;
+}
+
+/// copies an indexed dictionary section, with the value under the key replaced or added
+static std::vector<uint8_t> indexed(std::span<const uint8_t> data, uint32_t section, uint16_t key, std::span<const uint8_t> value) {
+	uint8_t count = load<uint8_t>(data, section);
+	std::vector<std::pair<uint16_t, std::span<const uint8_t>>> entries;
+	bool found = false;
+
+	for (uint32_t i = 0; i < count; i ++) {
+		uint16_t current = load<uint16_t>(data, section + 1 + i * 2);
+		uint16_t offset = load<uint16_t>(data, section + 1 + (count + i) * 2);
+
+		if (!found && current == key) {
+			entries.emplace_back(current, value);
+			found = true;
+		} else {
+			entries.emplace_back(current, slot(data, section + offset));
+		}
+	}
+
+	// new keys go after all the equal or smaller keys, to keep the column sorted
+	if (!found) {
+		if (count == 0xFF) {
+			throw std::runtime_error {"Unable to add another key, maximum dictionary capacity reached"};
+		}
+
+		auto it = std::upper_bound(entries.begin(), entries.end(), key, [] (uint16_t key, const auto& entry) {
+			return key < entry.first;
+		});
+
+		entries.emplace(it, key, value);
+	}
+
+	std::vector<uint8_t> output {(uint8_t) entries.size()};
+	uint32_t offset = 1 + entries.size() * 4;
+
+	for (auto& [current, bytes] : entries) {
+		store<uint16_t>(output, current);
+	}
+
+	for (auto& [current, bytes] : entries) {
+		store<uint16_t>(output, offset);
+		offset += bytes.size();
+	}
+
+	if (offset > 0xFFFF) {
+		throw std::runtime_error {"Unable to replace, the dictionary grew too large"};
+	}
+
+	for (auto& [current, bytes] : entries) {
+		output.insert(output.end(), bytes.begin(), bytes.end());
+	}
+
+	return output;
+}
+
+/// copies the records of a map section, with the key pointing to the value at the given offset relative to the values
+static std::vector<uint8_t> map(std::span<const uint8_t> data, uint32_t section, uint16_t key, uint32_t value) {
+	uint32_t count = load<uint32_t>(data, section);
+	uint32_t values = load<uint32_t>(data, section + 4);
+	std::vector<std::pair<uint16_t, uint32_t>> records;
+	bool found = false;
+
+	load<uint8_t>(data, section + 8 + (uint64_t) count * 6 - 1);
+	records.reserve(count + 1);
+
+	for (uint64_t i = 0; i < count; i ++) {
+		uint16_t current = load<uint16_t>(data, section + 8 + i * 6);
+		uint32_t offset = load<uint32_t>(data, section + 8 + i * 6 + 2);
+
+		// other records with the same key are dropped, so that the new value is the one found
+		if (current == key) {
+			if (!found) records.emplace_back(key, value);
+			found = true;
+			continue;
+		}
+
+		records.emplace_back(current, offset);
+	}
+
+	if (!found) {
+		auto it = std::upper_bound(records.begin(), records.end(), key, [] (uint16_t key, const auto& record) {
+			return key < record.first;
+		});
+
+		records.emplace(it, key, value);
+	}
+
+	std::vector<uint8_t> output (8 + records.size() * 6);
+	uint32_t size = records.size();
+
+	memcpy(output.data(), &size, 4);
+	memcpy(output.data() + 4, &values, 4);
+
+	for (size_t i = 0; i < records.size(); i ++) {
+		memcpy(output.data() + 8 + i * 6, &records[i].first, 2);
+		memcpy(output.data() + 8 + i * 6 + 2, &records[i].second, 4);
+	}
+
+	return output;
+}
+
+/// copies an array section, with the element at the index replaced
+static std::vector<uint8_t> list(std::span<const uint8_t> data, uint32_t section, uint32_t index, std::span<const uint8_t> value) {
+	uint32_t count = load<uint32_t>(data, section);
+	uint8_t node = load<uint8_t>(data, section + 4);
+	uint64_t size = 5 + (uint64_t) count * BinaryTreeNode::sizeOf(node);
+
+	if (index >= count) {
+		throw std::runtime_error {"Unable to replace, index " + std::to_string(index) + " is out of bounds"};
+	}
+
+	if (value[0] != node) {
+		throw std::runtime_error {std::string {"Expected array type: "} + BinaryTreeNode::nameOf(node) + ", but got: " + BinaryTreeNode::nameOf(value[0])};
+	}
+
+	load<uint8_t>(data, section + size - 1);
+
+	std::vector<uint8_t> output {data.begin() + section, data.begin() + section + size};
+	memcpy(output.data() + 5 + (uint64_t) index * BinaryTreeNode::sizeOf(node), value.data() + 1, value.size() - 1);
+
+	return output;
+}
+
+BinaryTreeEditor::BinaryTreeEditor(const std::string& path)
+: file(path) {
+
+	if (file.size() < BinaryTreeHeader::size) {
+		throw std::runtime_error {"File is too short to contain the header"};
+	}
+
+	Reader reader {file.data()};
+	BinaryTreeHeader header {reader};
+
+	if (!header.readable()) {
+		throw std::runtime_error {"Unsupported encoding"};
+	}
+
+	if (header.swapped()) {
+		throw std::runtime_error {"Unable to edit, the file uses the opposite byte order"};
+	}
+
+	if (header.flags & BinaryFlag::COMPRESSED) {
+		throw std::runtime_error {"Unable to edit, compressed files can't be modified"};
+	}
+
+	this->flags = header.flags;
+
+	// check the version table up front, the writes need to extend it
+	if (flags & BinaryFlag::VERSIONED) {
+		versions();
+	}
+}
+
+void BinaryTreeEditor::create(const std::string& path, const WriteConfig& config) {
+	SectionManager manager {config};
+	std::vector<uint8_t> table = BinaryTreeVersions::empty();
+
+	uint8_t bytes[BinaryTreeHeader::size];
+	BinaryTreeHeader {(uint16_t) (manager.flags() | BinaryFlag::VERSIONED), BinaryTreeHeader::size}.emit(bytes);
+
+	OutputFile output {path};
+	output.write(bytes, BinaryTreeHeader::size);
+	output.write(table.data(), table.size());
+	output.commit();
+}
+
+void BinaryTreeEditor::enableVersions() {
+	if (flags & BinaryFlag::VERSIONED) {
+		return;
+	}
+
+	uint32_t base = file.size();
+	std::vector<uint8_t> output;
+
+	// the table is aligned so that the header can be switched to it atomically later
+	while ((base + output.size()) % 4 != 0) {
+		output.push_back(0);
+	}
+
+	uint32_t table = base + output.size();
+
+	// the only version is the current tree, there are no older tables
+	store<uint32_t>(output, 0);
+	store<uint32_t>(output, 1);
+	store<uint32_t>(output, 0);
+	store<uint32_t>(output, offset());
+
+	if (base + (uint64_t) output.size() > 0xFFFFFFFF) {
+		throw std::runtime_error {"Unable to add versions, the file would grow past 4 GiB"};
+	}
+
+	file.append(output.data(), output.size());
+	file.sync();
+
+	// the flags and the offset can't be changed together, a reader in
+	// between would see the old root with the new flags, or the other way
+	updateFlags((flags | BinaryFlag::VERSIONED) & ~BinaryFlag::UNIQUE_SECTIONS);
+	std::atomic_ref<uint32_t> {*reinterpret_cast<uint32_t*>(file.data() + BinaryTreeHeader::size - 4)}.store(table);
+	file.sync();
+}
+
+void BinaryTreeEditor::updateFlags(uint16_t flags) {
+	this->flags = flags;
+	file.data()[6] = flags >> 8;
+	file.data()[7] = flags & 0xFF;
+}
+
+uint32_t BinaryTreeEditor::header() {
+	Reader reader {file.data()};
+	return BinaryTreeHeader {reader}.offset;
+}
+
+uint32_t BinaryTreeEditor::offset() {
+	if (flags & BinaryFlag::VERSIONED) {
+		BinaryTreeVersions table {file.data(), file.size(), header()};
+
+		if (table.size() == 0) {
+			throw std::runtime_error {"File has no versions"};
+		}
+
+		return table.root(table.size() - 1);
+	}
+
+	return header();
+}
+
+void BinaryTreeEditor::commit(SectionManager& manager, const BinaryTreeQuery& query) {
+	const std::vector<Step>& path = query.path();
+	std::span<const uint8_t> data {file.data(), file.size()};
+	std::vector<Frame> frames;
+
+	uint32_t base = file.size();
+	uint8_t type = 0;
+	uint64_t payload = 0;
+
+	// replacing the whole tree doesn't need the old one, a versioned file could have none yet
+	if (!path.empty()) {
+		type = load<uint8_t>(data, offset());
+		payload = offset() + 1;
+	}
+
+	// find all the containers on the path, the last one gets the new value
+	for (size_t i = 0; i < path.size(); i ++) {
+		const Step& step = path[i];
+
+		if (step.kind == Step::ALL) {
+			throw std::runtime_error {"Unable to replace, the path can't contain '*'"};
+		}
+
+		if (type != BinaryNode::DICT && type != BinaryNode::MAP && type != BinaryNode::LIST) {
+			throw std::runtime_error {std::string {"Unable to follow the path, "} + BinaryTreeNode::nameOf(type) + " has no children"};
+		}
+
+		if ((type == BinaryNode::LIST) != (step.kind == Step::INDEX)) {
+			throw std::runtime_error {std::string {"Unable to follow the path, "} + BinaryTreeNode::nameOf(type) + (step.kind == Step::INDEX ? " can't be indexed" : " has no keys")};
+		}
+
+		frames.push_back({type, load<uint32_t>(data, payload), step});
+
+		if (i + 1 < path.size()) {
+			std::tie(type, payload) = child(data, type, frames.back().section, step, flags);
+		}
+	}
+
+	// the new value is placed first, the root section holds its type and payload,
+	// the new sections are only deduplicated if the old ones could be shared too
+	WriteConfig config;
+	config.section_deduplication = !(flags & BinaryFlag::UNIQUE_SECTIONS);
+
+	std::vector<uint8_t> output;
+	manager.emit(output, base, config);
+
+	if (output.empty()) {
+		throw std::runtime_error {"Unable to replace, no value was written"};
+	}
+
+	std::vector<uint8_t> value {output.begin(), output.begin() + 1 + BinaryTreeNode::sizeOf(output[0])};
+
+	// copy the containers from the bottom up, each pointing to the copy of its child
+	for (const Frame& frame : frames | std::views::reverse) {
+		std::vector<uint8_t> section;
+
+		if (frame.type == BinaryNode::MAP) {
+			uint32_t values = load<uint32_t>(data, frame.section + 4);
+			uint32_t at = place(output, base, base + output.size(), value);
+
+			// the value is placed past the end of the values section, but
+			// still at an offset relative to it, so the values are not copied
+			section = map(data, frame.section, frame.step.value, at - values);
+		} else if (frame.type == BinaryNode::LIST) {
+			section = list(data, frame.section, frame.step.value, value);
+		} else if (flags & BinaryFlag::INDEXED_DICTS) {
+			section = indexed(data, frame.section, frame.step.value, value);
+		} else {
+			section = dict(data, frame.section, frame.step.value, value);
+		}
+
+		uint32_t at = place(output, base, frame.section, section);
+
+		value.resize(5);
+		value[0] = frame.type;
+		memcpy(value.data() + 1, &at, 4);
+	}
+
+	uint32_t root = place(output, base, base + output.size(), value);
+	publish(output, base, root);
+}
+
+void BinaryTreeEditor::publish(std::vector<uint8_t>& output, uint32_t base, uint32_t root) {
+	uint32_t offset = root;
+
+	// the new version table goes last, it lists all the roots of the newest table and this one
+	if (flags & BinaryFlag::VERSIONED) {
+		while ((base + output.size()) % 4 != 0) {
+			output.push_back(0);
+		}
+
+		std::vector<uint8_t> table = BinaryTreeVersions {file.data(), file.size(), header()}.next(root);
+
+		offset = base + output.size();
+		output.insert(output.end(), table.begin(), table.end());
+	}
+
+	if (base + (uint64_t) output.size() > 0xFFFFFFFF) {
+		throw std::runtime_error {"Unable to replace, the file would grow past 4 GiB"};
+	}
+
+	// the new sections need to be on disk before the header points to them,
+	// the root offset is aligned, so readers see either the old or the new one
+	file.append(output.data(), output.size());
+	file.sync();
+
+	std::atomic_ref<uint32_t> {*reinterpret_cast<uint32_t*>(file.data() + BinaryTreeHeader::size - 4)}.store(offset);
+	file.sync();
+}
+
+uint32_t BinaryTreeEditor::versions() {
+	if (flags & BinaryFlag::VERSIONED) {
+		return BinaryTreeVersions {file.data(), file.size(), header()}.size();
+	}
+
+	return 1;
+}
+
+BinaryTreeNode BinaryTreeEditor::root() {
+	Reader reader {file.data()};
+	BinaryTreeHeader header {reader};
+
+	reader.jump(offset());
+	return {reader};
+}
+
+BinaryTreeNode BinaryTreeEditor::root(uint32_t version) {
+	Reader reader {file.data()};
+	BinaryTreeHeader header {reader};
+
+	if (flags & BinaryFlag::VERSIONED) {
+		reader.jump(BinaryTreeVersions {file.data(), file.size(), header.offset}.root(version));
+	} else if (version != 0) {
+		throw std::runtime_error {"Version " + std::to_string(version) + " doesn't exist, the file has 1 versions"};
+	}
+
+	return {reader};
+}
+
+void BinaryTreeEditor::link(BinaryTreeNode::Writer writer, BinaryTreeNode node) {
+	const uint8_t* payload = static_cast<const uint8_t*>(node.data());
+
+	if (payload < file.data() || payload + BinaryTreeNode::sizeOf(node.type()) > file.data() + file.size()) {
+		throw std::runtime_error {"Node doesn't belong to the edited file"};
+	}
+
+	// the node can now be reached from two places, so it can't be overwritten in place anymore
+	if (flags & BinaryFlag::UNIQUE_SECTIONS) {
+		updateFlags(flags & ~BinaryFlag::UNIQUE_SECTIONS);
+	}
+
+	writer.reuse(node);
+}
+
+void BinaryTreeEditor::sync() {
+	file.sync();
+}
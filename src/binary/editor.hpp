@@ -0,0 +1,121 @@
+
+#pragma once
+#include <common/external.hpp>
+#include <common/file.hpp>
+
+#include "nodes.hpp"
+#include "header.hpp"
+#include "query.hpp"
+#include "versions.hpp"
+
+/// modifies an existing file without rewriting it, primitives can be overwritten in place, other changes
+/// append a copy of every section on the path to the changed value and then switch the root in the header,
+/// the old sections are never modified, so readers that already hold nodes keep seeing the old tree, in files
+/// with the `VERSIONED` flag each change instead adds a new version, and the old ones stay readable by index
+class BinaryTreeEditor {
+
+	private:
+
+		UpdateFile file;
+		uint16_t flags;
+
+		/// a container on the path to the changed value
+		struct Frame {
+			uint8_t type;
+			uint32_t section;
+			BinaryTreeQuery::Step step;
+		};
+
+		/// appends the root section built by the manager at the end of the path and updates the header
+		void commit(SectionManager& manager, const BinaryTreeQuery& path);
+
+		/// appends the output that starts at `base`, followed by the new version table for versioned files,
+		/// and then switches the header to the new root slot or table once everything is on disk
+		void publish(std::vector<uint8_t>& output, uint32_t base, uint32_t root);
+
+		/// sets the flags, both here and in the header of the file
+		void updateFlags(uint16_t flags);
+
+		/// returns the offset stored in the header, for versioned files that is the newest version table
+		uint32_t header();
+
+		/// returns the offset of the root slot of the newest version
+		uint32_t offset();
+
+	public:
+
+		/// opens the file for editing, compressed files and files in the opposite byte order are not supported
+		BinaryTreeEditor(const std::string& path);
+
+		/// creates an empty versioned file at the path, replacing any existing one,
+		/// the dictionaries and texts of all versions use the layout from the config
+		static void create(const std::string& path, const WriteConfig& config = {});
+
+		/// adds the `VERSIONED` flag to the file, the current tree becomes the first version, the
+		/// header is updated in two steps, so no other process should read the file in the meantime
+		void enableVersions();
+
+		/// returns the number of versions in the file, files without the `VERSIONED` flag always have one
+		uint32_t versions();
+
+		/// returns the root node, the nodes point into the writable mapping of the
+		/// file, so they are only valid until the next call to `replace()`
+		BinaryTreeNode root();
+
+		/// returns the root node of the given version, the first version has index zero
+		BinaryTreeNode root(uint32_t version);
+
+		/// writes the node, that has to come from this editor, as the value of the writer, without copying any
+		/// of its sections, so unchanged subtrees of old versions can be shared by the new one, call it from the
+		/// function passed to `replace()` before anything that would invalidate the node, this removes the
+		/// `UNIQUE_SECTIONS` flag, so `set()` can't be used on the file afterwards
+		void link(BinaryTreeNode::Writer writer, BinaryTreeNode node);
+
+		/// overwrites the value of a primitive or vector node returned by this editor in place, the
+		/// new value becomes visible to all readers right away, use `sync()` to make it durable
+		///
+		/// a value stored in a section that is shared, by deduplication or by `link()`, would change
+		/// under every path that leads to it, so this is only allowed for files with the `UNIQUE_SECTIONS`
+		/// flag, which are written with `section_deduplication` disabled, versioned files never have it
+		template <typename T>
+		void set(BinaryTreeNode node, typename T::type value) {
+			if (flags & BinaryFlag::VERSIONED) {
+				throw std::runtime_error {"Unable to overwrite in place, the file is versioned, use replace() instead"};
+			}
+
+			if (!(flags & BinaryFlag::UNIQUE_SECTIONS)) {
+				throw std::runtime_error {"Unable to overwrite in place, sections of the file could be shared, write it without section deduplication or use replace() instead"};
+			}
+
+			node.as<T>();
+
+			const uint8_t* payload = static_cast<const uint8_t*>(node.data());
+
+			if (payload < file.data() || payload + sizeof(value) > file.data() + file.size()) {
+				throw std::runtime_error {"Node doesn't belong to the edited file"};
+			}
+
+			memcpy(file.data() + (payload - file.data()), &value, sizeof(value));
+		}
+
+		/// replaces the value at the path with the one written by the function, or adds it if the last step is a missing
+		/// key, the function is called with a `BinaryTreeNode::Writer`, only the sections on the path are copied, so
+		/// the cost depends on the depth and not on the size of the file, arrays are copied whole though, an empty
+		/// path replaces the whole tree, for versioned files the result is stored as a new version
+		template <typename F>
+		void replace(const BinaryTreeQuery& path, F function) {
+			WriteConfig config;
+			config.indexed_dicts = flags & BinaryFlag::INDEXED_DICTS;
+			config.sized_text = flags & BinaryFlag::SIZED_TEXT;
+
+			SectionManager manager {config};
+			BinaryTreeNode::Writer writer {&manager, manager.allocate()};
+
+			function(writer);
+			commit(manager, path);
+		}
+
+		/// flushes all the changes to disk
+		void sync();
+
+};
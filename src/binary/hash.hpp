@@ -0,0 +1,108 @@
+
+#pragma once
+#include <common/external.hpp>
+
+/// a self-contained 64 bit hash in the style of wyhash, this is only ever
+/// used for in-memory lookups so the value doesn't need to be portable
+class SectionHash {
+
+	private:
+
+		static constexpr uint64_t secret[4] = {0xa0761d6478bd642f, 0xe7037ed1a0b428db, 0x8ebc6af09c88c6e3, 0x589965cc75374cc3};
+
+		static inline void multiply(uint64_t* a, uint64_t* b) {
+#if defined(__SIZEOF_INT128__)
+			__uint128_t r = *a;
+			r *= *b;
+			*a = (uint64_t) r;
+			*b = (uint64_t) (r >> 64);
+#else
+			uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+			uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+			uint64_t lo = t + (rm1 << 32);
+			c += lo < t;
+			*a = lo;
+			*b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+		}
+
+		static inline uint64_t mix(uint64_t a, uint64_t b) {
+			multiply(&a, &b);
+			return a ^ b;
+		}
+
+		static inline uint64_t read8(const uint8_t* p) {
+			uint64_t value;
+			memcpy(&value, p, 8);
+			return value;
+		}
+
+		static inline uint64_t read4(const uint8_t* p) {
+			uint32_t value;
+			memcpy(&value, p, 4);
+			return value;
+		}
+
+		static inline uint64_t read3(const uint8_t* p, size_t k) {
+			return (((uint64_t) p[0]) << 16) | (((uint64_t) p[k >> 1]) << 8) | p[k - 1];
+		}
+
+	public:
+
+		/// hashes all `length` bytes of the given data
+		static inline uint64_t of(const void* data, size_t length, uint64_t seed = 0) {
+			const uint8_t* p = static_cast<const uint8_t*>(data);
+			seed ^= mix(seed ^ secret[0], secret[1]);
+
+			uint64_t a, b;
+
+			if (length <= 16) {
+				if (length >= 4) {
+					a = (read4(p) << 32) | read4(p + ((length >> 3) << 2));
+					b = (read4(p + length - 4) << 32) | read4(p + length - 4 - ((length >> 3) << 2));
+				} else if (length > 0) {
+					a = read3(p, length);
+					b = 0;
+				} else {
+					a = b = 0;
+				}
+			} else {
+				size_t i = length;
+
+				if (i > 48) {
+					uint64_t see1 = seed, see2 = seed;
+
+					do {
+						seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+						see1 = mix(read8(p + 16) ^ secret[2], read8(p + 24) ^ see1);
+						see2 = mix(read8(p + 32) ^ secret[3], read8(p + 40) ^ see2);
+						p += 48;
+						i -= 48;
+					} while (i > 48);
+
+					seed ^= see1 ^ see2;
+				}
+
+				while (i > 16) {
+					seed = mix(read8(p) ^ secret[1], read8(p + 8) ^ seed);
+					i -= 16;
+					p += 16;
+				}
+
+				a = read8(p + i - 16);
+				b = read8(p + i - 8);
+			}
+
+			a ^= secret[1];
+			b ^= seed;
+			multiply(&a, &b);
+
+			return mix(a ^ secret[0] ^ length, b ^ secret[1]);
+		}
+
+		/// combines two hash values into one, the order matters
+		static inline uint64_t combine(uint64_t first, uint64_t second) {
+			return mix(first ^ secret[0], second ^ secret[2]);
+		}
+
+};
@@ -3,6 +3,7 @@
 #include <common/external.hpp>
 
 #include "reader.hpp"
+#include "types.hpp"
 
 #define BT_VERSION 1
 
@@ -46,6 +47,12 @@ class BinaryTreeHeader {
 			this->flags = (first << 8) | second; // big endian
 
 			this->offset = reader.read<uint32_t>();
+
+			if (swapped()) {
+				this->offset = ByteSwap::value(this->offset);
+			}
+
+			reader.flags(this->flags);
 			reader.jump(this->offset);
 
 		}
@@ -61,17 +68,30 @@ class BinaryTreeHeader {
 
 	public:
 
+		void emit(uint8_t* buffer) const {
+			memcpy(buffer, signature, 4);
+			buffer[4] = this->version;
+			buffer[5] = this->endian;
+			buffer[6] = this->flags >> 8;
+			buffer[7] = this->flags & 0xFF;
+			memcpy(buffer + 8, &this->offset, 4);
+		}
+
 		void emit(std::vector<uint8_t>& buffer) const {
-			buffer.insert(buffer.end(), signature, signature + 4);
-			buffer.push_back(this->version);
-			buffer.push_back(this->endian);
-			buffer.push_back(this->flags >> 8);
-			buffer.push_back(this->flags & 0xFF);
-			buffer.insert(buffer.end(), (uint8_t*) &this->offset, (uint8_t*) &this->offset + 4);
+			uint8_t bytes[size];
+			emit(bytes);
+			buffer.insert(buffer.end(), bytes, bytes + size);
 		}
 
+		/// checks if the file can be read, files in the opposite byte order
+		/// are readable too, but they need to be read with a `SwappedReader`
 		bool readable() const {
-			return (this->version == BT_VERSION) && (this->endian == endianness());
+			return (this->version == BT_VERSION) && (this->endian == 0x00 || this->endian == 0xFF) && !(this->flags & ~BinaryFlag::supported);
+		}
+
+		/// checks if the file was written in the opposite byte order
+		bool swapped() const {
+			return this->endian != endianness();
 		}
 
 };
@@ -3,6 +3,13 @@
 #include <common/file.hpp>
 #include "nodes.hpp"
 #include "header.hpp"
+#include "blocks.hpp"
+#include "validator.hpp"
+#include "query.hpp"
+#include "prefetch.hpp"
+#include "editor.hpp"
+#include "versions.hpp"
+#include "paged.hpp"
 
 struct BinaryTree {
 
@@ -10,28 +17,267 @@ struct BinaryTree {
 
 		private:
 
-			InputFile file;
+			// the source of the data, none is set if the caller holds it in memory
+			std::unique_ptr<InputFile> file;
+			std::unique_ptr<PagedSource> pages;
+
+			// the whole file, null when it is read in pages
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+
 			Reader reader;
 
-		public:
+			// only used for compressed files
+			std::unique_ptr<BlockCache> blocks;
+
+			// the blocks or pages the offsets are resolved through, if any
+			SectionSource* source = nullptr;
+			uint32_t offset;
+
+			// set for files written in the opposite byte order
+			bool swapped;
+
+			// only used for files with the `VERSIONED` flag
+			std::unique_ptr<BinaryTreeVersions> table;
 
-			Input(const std::string& path)
-			: file(path.c_str()) {
+			// the background walk started by `prefetch()`
+			std::unique_ptr<BinaryTreePrefetcher> prefetcher;
+			std::thread worker;
 
-				Reader reader {file.data()};
-				BinaryTreeHeader header {reader};
+			/// stops the running prefetch, if any, and waits for it to exit
+			void cancel() {
+				if (worker.joinable()) {
+					prefetcher->stop();
+					worker.join();
+				}
+			}
+
+			/// reads the header and prepares the reader, the version table and block cache if needed
+			void open(bool validate) {
+
+				if (size < BinaryTreeHeader::size) {
+					throw std::runtime_error {"File is too short to contain the header"};
+				}
+
+				uint8_t bytes[BinaryTreeHeader::size];
+
+				if (pages) {
+					pages->read(0, bytes, BinaryTreeHeader::size);
+				} else {
+					memcpy(bytes, data, BinaryTreeHeader::size);
+				}
+
+				Reader head {bytes};
+				BinaryTreeHeader header {head};
 
 				if (!header.readable()) {
 					throw std::runtime_error {"Unsupported encoding"};
 				}
 
-				this->reader = reader;
+				this->source = pages.get();
+
+				if (header.flags & BinaryFlag::COMPRESSED) {
+					if (pages) {
+						throw std::runtime_error {"Unable to read compressed files in pages, map them instead"};
+					}
+
+					blocks = std::make_unique<BlockCache>(data, size, 16, header.swapped());
+					source = blocks.get();
+				}
+
+				this->reader = Reader {data, source, header.flags};
+				this->offset = header.offset;
+				this->swapped = header.swapped();
+
+				// the header points to the version table, the newest version is opened by default
+				if (header.flags & BinaryFlag::VERSIONED) {
+					table = BinaryTree::versions(data, size, source, header);
+
+					if (table->size() > 0) {
+						this->offset = table->root(table->size() - 1);
+					}
+				}
+
+				if (validate) {
+					BinaryTree::validate(data, size, source, header, table.get());
+				}
+			}
+
+		public:
+
+			/// opens the file, when `validate` is set the whole tree is checked once up front (see
+			/// `BinaryTree::validate()`), so that the unchecked accessors are safe to use on untrusted files,
+			/// the `config` controls how the file is mapped, see `InputConfig`, use "-" to read standard input
+			Input(const std::string& path, bool validate = false, const InputConfig& config = {})
+			: file(std::make_unique<InputFile>(path, config)) {
+				this->data = file->data();
+				this->size = file->size();
+				open(validate);
+			}
+
+			/// reads a file that is already in memory, like a received buffer, without copying
+			/// it, the data needs to stay valid for as long as this input and its nodes are used
+			Input(std::span<const uint8_t> data, bool validate = false)
+			: data(data.data()), size(data.size()) {
+				open(validate);
+			}
+
+			/// reads the file in pages with positional reads instead of mapping it, see `PagedSource`, the
+			/// pages are released by `root()` and `read()` just like the blocks of compressed files, which
+			/// are not supported in this mode, as their blocks would need to be copied into memory too
+			Input(const std::string& path, const PagedConfig& config, bool validate = false)
+			: pages(std::make_unique<PagedSource>(path, config)) {
+				this->size = pages->size();
+				open(validate);
+			}
+
+			~Input() {
+				cancel();
 			}
 
+			/// starts loading the sections reachable from the node on a background thread, so that reading them
+			/// later doesn't need to wait for the disk, any previous prefetch is stopped first, compressed files
+			/// are requested as a whole, as their sections can't be found without decompressing the blocks
+			template <typename R>
+			void prefetch(BasicBinaryTreeNode<R> node) {
+				cancel();
+
+				if (!file || !file->mapped()) {
+					return;
+				}
+
+				if (blocks) {
+					file->advise(0, size, InputAdvice::WILLNEED);
+					return;
+				}
+
+				uint64_t payload = static_cast<const uint8_t*>(node.data()) - data;
+				uint8_t type = node.type();
+
+				prefetcher = std::make_unique<BinaryTreePrefetcher>(*file, reader.flags(), swapped);
+				worker = std::thread {[this, type, payload] () {
+					prefetcher->run(type, payload);
+				}};
+			}
+
+			/// returns the number of versions stored in the file, files
+			/// without the `VERSIONED` flag always have exactly one
+			uint32_t versions() const {
+				return table ? table->size() : 1;
+			}
+
+			/// makes `root()` and `read()` return the root of the given version, the
+			/// first version has index zero, nodes created before this call stay valid
+			void select(uint32_t version) {
+				if (table) {
+					offset = table->root(version);
+				} else if (version != 0) {
+					throw std::runtime_error {"Version " + std::to_string(version) + " doesn't exist, the file has 1 versions"};
+				}
+			}
+
+			/// returns the root node, for compressed files this also evicts the least recently
+			/// used blocks, which invalidates all the nodes and views created before this call,
+			/// files written in the opposite byte order can only be accessed with `read()`
 			BinaryTreeNode root() {
+				if (swapped) {
+					throw std::runtime_error {"File uses the opposite byte order, use read() instead"};
+				}
+
+				if (versions() == 0) {
+					throw std::runtime_error {"File has no versions"};
+				}
+
+				if (source) {
+					source->trim();
+				}
+
+				// the block with the root could have been evicted, or another version selected
+				reader.jump(offset);
 				return {reader};
 			}
 
+			/// calls the function with the root node and returns its result, for files written in the
+			/// opposite byte order the node is a `BasicBinaryTreeNode<SwappedReader>`, so the function
+			/// needs to accept both, for example by taking `auto`, the same rules as for `root()` apply
+			template <typename F>
+			decltype(auto) read(F function) {
+				if (versions() == 0) {
+					throw std::runtime_error {"File has no versions"};
+				}
+
+				if (source) {
+					source->trim();
+				}
+
+				reader.jump(offset);
+
+				if (swapped) {
+					return function(BasicBinaryTreeNode<SwappedReader> {SwappedReader {reader}});
+				}
+
+				return function(BinaryTreeNode {reader});
+			}
+
 	};
 
+	/// checks that all the sections reachable from the root of the given file lie within it, throws
+	/// a runtime error describing the first problem found, returns the number of checked links
+	static size_t validate(const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+		if (size < BinaryTreeHeader::size) {
+			throw std::runtime_error {"File is too short to contain the header"};
+		}
+
+		Reader reader {bytes};
+		BinaryTreeHeader header {reader};
+		std::unique_ptr<BlockCache> blocks;
+
+		if (!header.readable()) {
+			throw std::runtime_error {"Unsupported encoding"};
+		}
+
+		if (header.flags & BinaryFlag::COMPRESSED) {
+			blocks = std::make_unique<BlockCache>(bytes, size, 16, header.swapped());
+		}
+
+		std::unique_ptr<BinaryTreeVersions> table;
+
+		if (header.flags & BinaryFlag::VERSIONED) {
+			table = versions(bytes, size, blocks.get(), header);
+		}
+
+		return validate(bytes, size, blocks.get(), header, table.get());
+	}
+
+	private:
+
+		/// reads the version table of a file with the `VERSIONED` flag
+		static std::unique_ptr<BinaryTreeVersions> versions(const uint8_t* data, size_t size, SectionSource* source, const BinaryTreeHeader& header) {
+			if (header.flags & BinaryFlag::COMPRESSED) {
+				throw std::runtime_error {"Unsupported encoding, versioned files can't be compressed"};
+			}
+
+			return std::make_unique<BinaryTreeVersions>(data, size, header.offset, header.swapped(), source);
+		}
+
+		/// checks the trees of all versions, the sections shared between
+		/// them are remembered by the validator, so they are only checked once
+		static size_t validate(const uint8_t* data, size_t size, SectionSource* source, const BinaryTreeHeader& header, const BinaryTreeVersions* table) {
+			BinaryTreeValidator validator {data, size, source, header.flags, header.swapped()};
+
+			if (!table) {
+				return validator.validate(header.offset);
+			}
+
+			size_t checked = 0;
+
+			for (uint32_t version = 0; version < table->size(); version ++) {
+				checked = validator.validate(table->root(version));
+			}
+
+			return checked;
+		}
+
 };
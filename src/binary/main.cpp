@@ -4,87 +4,112 @@
 
 #include <iostream>
 
-void save(const char* path, std::vector<uint8_t>& output) {
+template <typename T, typename R>
+void print(BasicBinaryTreeNode<R> node) {
+	auto vector = node.template as<T>();
+	std::cout << " (";
 
-	FILE* file = fopen(path, "wb");
+	for (size_t i = 0; i < vector.size(); i ++) {
+		std::cout << (i ? ", " : "") << +vector[i];
+	}
+
+	std::cout << ")\n";
+}
+
+template <typename R>
+void visit(BasicBinaryTreeNode<R> node, int depth, std::vector<bool> flags = {});
 
-	if (!file) {
-		throw std::runtime_error {"Failed to open file"};
+template <typename T>
+void entries(T dict, int depth, std::vector<bool>& flags) {
+	std::cout << " (" << dict.size() << " entries)\n";
+
+	int counter = dict.size();
+
+	if (flags.size() >= depth) {
+		std::vector<bool> child {flags};
+		child.push_back(false);
+
+		padding(child);
+		std::cout << "(... " << dict.size() << " more)\n";
+		return;
 	}
 
-	fwrite(output.data(), 1, output.size(), file);
-	fclose(file);
+	for (auto [key, node] : dict) {
+		std::vector<bool> child {flags};
+		child.push_back(-- counter);
 
+		padding(child);
+		std::cout << key << " ";
+		visit(node, depth, child);
+	}
 }
 
-void visit(BinaryTreeNode node, int depth, std::vector<bool> flags = {}) {
+template <typename R>
+void visit(BasicBinaryTreeNode<R> node, int depth, std::vector<bool> flags) {
 
 	std::cout << node.name();
 
 	if (node.type() == BinaryNode::LONG) {
-		std::cout << " " << node.as<BinaryTreeLong>() << "\n";
+		std::cout << " " << node.template as<BinaryTreeLong>() << "\n";
 		return;
 	}
 
 	if (node.type() == BinaryNode::INT) {
-		std::cout << " " << node.as<BinaryTreeInt>() << "\n";
+		std::cout << " " << node.template as<BinaryTreeInt>() << "\n";
 		return;
 	}
 
 	if (node.type() == BinaryNode::SHORT) {
-		std::cout << " " << node.as<BinaryTreeShort>() << "\n";
+		std::cout << " " << node.template as<BinaryTreeShort>() << "\n";
 		return;
 	}
 
 	if (node.type() == BinaryNode::BYTE) {
-		std::cout << " " << (int) node.as<BinaryTreeByte>() << "\n";
+		std::cout << " " << (int) node.template as<BinaryTreeByte>() << "\n";
 		return;
 	}
 
 	if (node.type() == BinaryNode::DOUBLE) {
-		std::cout << " " << node.as<BinaryTreeDouble>() << "\n";
+		std::cout << " " << node.template as<BinaryTreeDouble>() << "\n";
 		return;
 	}
 
 	if (node.type() == BinaryNode::FLOAT) {
-		std::cout << " " << node.as<BinaryTreeFloat>() << "\n";
+		std::cout << " " << node.template as<BinaryTreeFloat>() << "\n";
 		return;
 	}
 
-	if (node.type() == BinaryNode::DICT) {
-		auto dict = node.as<BinaryTreeDict>();
-		std::cout << " (" << dict.size() << " entries)\n";
-
-		int counter = dict.size();
-
-		if (flags.size() >= depth) {
-			std::vector<bool> child {flags};
-			child.push_back(false);
+	if (node.type() == BinaryNode::VEC2F) return print<BinaryTreeVec2f>(node);
+	if (node.type() == BinaryNode::VEC3F) return print<BinaryTreeVec3f>(node);
+	if (node.type() == BinaryNode::VEC2I) return print<BinaryTreeVec2i>(node);
+	if (node.type() == BinaryNode::VEC3I) return print<BinaryTreeVec3i>(node);
+	if (node.type() == BinaryNode::VEC2S) return print<BinaryTreeVec2s>(node);
+	if (node.type() == BinaryNode::VEC3S) return print<BinaryTreeVec3s>(node);
+	if (node.type() == BinaryNode::VEC4S) return print<BinaryTreeVec4s>(node);
+	if (node.type() == BinaryNode::VEC2B) return print<BinaryTreeVec2b>(node);
+	if (node.type() == BinaryNode::VEC3B) return print<BinaryTreeVec3b>(node);
+	if (node.type() == BinaryNode::VEC4B) return print<BinaryTreeVec4b>(node);
 
-			padding(child);
-			std::cout << "(... " << dict.size() << " more)\n";
-			return;
-		}
-
-		for (auto [key, node] : dict) {
-			std::vector<bool> child {flags};
-			child.push_back(-- counter);
+	if (node.type() == BinaryNode::DICT) {
+		return entries(node.template as<BinaryTreeDict>(), depth, flags);
+	}
 
-			padding(child);
-			std::cout << key << " ";
-			visit(node, depth, child);
-		}
+	if (node.type() == BinaryNode::MAP) {
+		return entries(node.template as<BinaryTreeMap>(), depth, flags);
+	}
 
+	if (node.type() == BinaryNode::TEXT) {
+		std::cout << " \"" << node.template as<BinaryTreeText>().view() << "\"\n";
 		return;
 	}
 
-	if (node.type() == BinaryNode::TEXT) {
-		std::cout << " \"" << node.as<BinaryTreeText>().data() << "\"\n";
+	if (node.type() == BinaryNode::BLOB) {
+		std::cout << " (" << node.template as<BinaryTreeBlob>().size() << " bytes)\n";
 		return;
 	}
 
 	if (node.type() == BinaryNode::LIST) {
-		auto array = node.as<BinaryTreeArray<BinaryTreeNode>>();
+		auto array = node.template as<BinaryTreeArray<BinaryTreeNode>>();
 		std::cout << "<" << array.name() << "> (" << array.size() << " entries)\n";
 
 		int counter = array.size();
@@ -147,15 +172,14 @@ bool make(const std::string& path) {
 
 	dict1.put(0x5).as<BinaryTreeText>("Bit by bit into the abyss!");
 
-	std::vector<uint8_t> output;
-	WriteResult result = context.emit(output);
-
-	save(path.c_str(), output);
+	WriteResult result = context.emit(path);
 
 	std::cout << "Write Result:\n";
 	std::cout << " * Cache-hits   : " << result.cache_hits   << " (saved " << result.total_skipped << " bytes)\n";
 	std::cout << " * Cache-misses : " << result.cache_misses << "\n";
-	std::cout << " * Cache-failes : " << result.cache_fails  << "\n\n";
+	std::cout << " * Cache-failes : " << result.cache_fails  << "\n";
+	std::cout << " * Cache-probes : " << result.cache_probes << " (" << result.cache_evictions << " evictions)\n";
+	std::cout << " * Allocations  : " << result.allocations  << "\n\n";
 
 	std::cout << "File generated, it contain at least one instance of each node type.\n";
 	std::cout << "You can display it using 'bt show " << path << "'\n";
@@ -176,26 +200,88 @@ bool info(const std::string& path) {
 
 	std::cout << "Size             : " << file.size() << " bytes (" << (file.size() - 12) << " bytes of data)\n";
 	std::cout << "Version    +0x04 : BT v" << (int) header.version << "\n";
-	std::cout << "Endianness +0x05 : " << (header.endian ? "little-endian" : "big-endian") << "\n";
-	std::cout << "Flags      +0x06 : " << header.flags << "\n";
-	std::cout << "Root       +0x08 : 0x" << std::hex << header.offset << std::dec << "\n";
+	std::cout << "Endianness +0x05 : " << (header.endian ? "little-endian" : "big-endian") << (header.swapped() ? " (converted on read)" : "") << "\n";
+	std::cout << "Flags      +0x06 : " << header.flags;
+	if (header.flags & BinaryFlag::COMPRESSED) std::cout << " (compressed)";
+	if (header.flags & BinaryFlag::INDEXED_DICTS) std::cout << " (indexed dicts)";
+	if (header.flags & BinaryFlag::SIZED_TEXT) std::cout << " (sized text)";
+	if (header.flags & BinaryFlag::VERSIONED) std::cout << " (versioned)";
+	if (header.flags & BinaryFlag::UNIQUE_SECTIONS) std::cout << " (unique sections)";
+	std::cout << "\n";
+	std::cout << (header.flags & BinaryFlag::VERSIONED ? "Table      +0x08 : 0x" : "Root       +0x08 : 0x") << std::hex << header.offset << std::dec << "\n";
 
 	if (!header.readable()) {
 		std::cout << "Encoding differs, this file can't be read! Aborting...\n";
 		return 1;
 	}
 
+	if (header.flags & BinaryFlag::VERSIONED) {
+		BinaryTreeVersions table {file.data(), file.size(), header.offset, header.swapped()};
+		std::cout << "Versions         : " << table.size() << "\n";
+	}
+
 	return 0;
 }
 
 bool tree(const std::string& path) {
 
 	BinaryTree::Input file {path};
-	visit(file.root(), 30);
+
+	file.read([] (auto root) {
+		visit(root, 30);
+	});
+
 	return 0;
 }
 
 
+bool verify(const std::string& path) {
+
+	InputFile file {path.c_str()};
+
+	try {
+		size_t links = BinaryTree::validate(file.data(), file.size());
+		std::cout << "File is valid, checked " << links << " links\n";
+	} catch (std::runtime_error& error) {
+		std::cout << "File is not valid: " << error.what() << "\n";
+		return 1;
+	}
+
+	return 0;
+}
+
+bool query(const std::string& path, const std::vector<std::string>& queries) {
+
+	BinaryTree::Input file {path, true};
+	BinaryTreeQueryBatch batch;
+
+	try {
+		for (const std::string& query : queries) {
+			batch.add(BinaryTreeQuery {query});
+		}
+	} catch (std::runtime_error& error) {
+		std::cout << error.what() << "\n";
+		return 1;
+	}
+
+	file.read([&] (auto root) {
+		auto results = batch.run(root);
+
+		for (size_t i = 0; i < queries.size(); i ++) {
+			if (results[i].empty()) {
+				std::cout << queries[i] << " (no match)\n";
+			}
+
+			for (auto node : results[i]) {
+				std::cout << queries[i] << " ";
+				visit(node, 0);
+			}
+		}
+	});
+
+	return 0;
+}
+
 bool show(const std::string& path) {
 	int a = info(path);
 
@@ -235,12 +321,14 @@ int help() {
 	std::cout << "A helper utility for the BinaryTree file format\n\n";
 
 	std::cout << "Modes:\n";
-	std::cout << "   version     : Show version and exit\n";
-	std::cout << "   help        : Show this page and exit\n";
-	std::cout << "   info [file] : Show basic stats about a BT file\n";
-	std::cout << "   tree [file] : Show the structure stored in given file\n";
-	std::cout << "   show [file] : Show a combination of the 'stat' and 'tree' modes\n";
-	std::cout << "   make [file] : Generate an example file and exit\n\n";
+	std::cout << "   version                : Show version and exit\n";
+	std::cout << "   help                   : Show this page and exit\n";
+	std::cout << "   info [file]            : Show basic stats about a BT file\n";
+	std::cout << "   tree [file]            : Show the structure stored in given file\n";
+	std::cout << "   show [file]            : Show a combination of the 'stat' and 'tree' modes\n";
+	std::cout << "   verify [file]          : Check that the structure of a BT file is intact\n";
+	std::cout << "   make [file]            : Generate an example file and exit\n";
+	std::cout << "   query [file] [path...] : Show the values at the given paths, like '4/2/[3]' or '8/*'\n\n";
 
 	return 0;
 }
@@ -276,6 +364,14 @@ int main(int argc, char** argv) {
 		return show(args[1]);
 	}
 
+	if (args.size() == 2 && args[0] == "verify") {
+		return verify(args[1]);
+	}
+
+	if (args.size() >= 3 && args[0] == "query") {
+		return query(args[1], {args.begin() + 2, args.end()});
+	}
+
 	if (args.size() == 2 && args[0] == "make") {
 		return make(args[1]);
 	}
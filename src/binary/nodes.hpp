@@ -9,11 +9,15 @@
 
 #include "nodes/node.hpp"
 #include "nodes/primitive.hpp"
+#include "nodes/vector.hpp"
 #include "nodes/text.hpp"
+#include "nodes/blob.hpp"
 #include "nodes/array.hpp"
 #include "nodes/dict.hpp"
+#include "nodes/map.hpp"
 
-constexpr const char* BinaryTreeNode::nameOf(uint8_t node) {
+template <typename R>
+constexpr const char* BasicBinaryTreeNode<R>::nameOf(uint8_t node) {
 
 	// primitives
 	if (node == BinaryNode::DOUBLE) return "Double";
@@ -23,14 +27,29 @@ constexpr const char* BinaryTreeNode::nameOf(uint8_t node) {
 	if (node == BinaryNode::SHORT) return "Short";
 	if (node == BinaryNode::BYTE) return "Byte";
 
+	// vectors
+	if (node == BinaryNode::VEC2F) return "Vec2f";
+	if (node == BinaryNode::VEC3F) return "Vec3f";
+	if (node == BinaryNode::VEC2I) return "Vec2i";
+	if (node == BinaryNode::VEC3I) return "Vec3i";
+	if (node == BinaryNode::VEC2S) return "Vec2s";
+	if (node == BinaryNode::VEC3S) return "Vec3s";
+	if (node == BinaryNode::VEC4S) return "Vec4s";
+	if (node == BinaryNode::VEC2B) return "Vec2b";
+	if (node == BinaryNode::VEC3B) return "Vec3b";
+	if (node == BinaryNode::VEC4B) return "Vec4b";
+
 	// compounds
 	if (node == BinaryNode::TEXT) return "Text";
+	if (node == BinaryNode::BLOB) return "Blob";
 	if (node == BinaryNode::DICT) return "Dictionary";
+	if (node == BinaryNode::MAP) return "Map";
 	if (node == BinaryNode::LIST) return "Array";
 
 	return "Undefined";
 }
 
-constexpr uint32_t BinaryTreeNode::sizeOf(uint8_t node) {
+template <typename R>
+constexpr uint32_t BasicBinaryTreeNode<R>::sizeOf(uint8_t node) {
 	return node & 0x0f;
 }
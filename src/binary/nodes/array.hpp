@@ -5,6 +5,13 @@
 template <typename T>
 class BinaryTreeArray {
 
+	private:
+
+		using R = typename T::reader_type;
+
+		// array can be templated with a node to iterate in a generic way
+		static constexpr bool generic = std::is_same_v<T, BasicBinaryTreeNode<R>>;
+
 	public:
 
 		class Writer {
@@ -22,6 +29,21 @@ class BinaryTreeArray {
 					writer->write<uint32_t>(0);
 					writer->write<uint8_t>(T::header);
 					buffer->link(writer);
+
+					// the elements start right after the count and type
+					uint32_t alignment = 1;
+
+					if constexpr (requires { T::alignment; }) {
+						alignment = T::alignment;
+					}
+
+					if constexpr (requires { typename T::type; }) {
+						alignment = std::max(alignment, manager->alignment(sizeof(typename T::type)));
+					}
+
+					if (alignment > 1) {
+						writer->align(alignment, 5);
+					}
 				}
 
 				template <typename... Args>
@@ -31,6 +53,59 @@ class BinaryTreeArray {
 					return {manager, writer, args...};
 				}
 
+				/// the values that can be appended in bulk, arithmetic values are converted like
+				/// in `put()`, but floating point values are never truncated into integers
+				template <typename V>
+				static constexpr bool accepts = std::same_as<V, typename T::type> || (std::is_arithmetic_v<typename T::type> && (std::integral<V> || (std::floating_point<V> && std::floating_point<typename T::type>)));
+
+				/// appends all the values at once, the values are converted
+				/// just like in `put()` but the count is only updated once
+				template <typename V> requires accepts<V>
+				void putAll(std::span<const V> values) {
+					using E = typename T::type;
+					uint8_t* target = writer->extend(values.size() * sizeof(E));
+
+					if constexpr (std::is_same_v<E, V>) {
+						memcpy(target, values.data(), values.size_bytes());
+					} else {
+						for (size_t i = 0; i < values.size(); i ++) {
+							E value = static_cast<E>(values[i]);
+							memcpy(target + i * sizeof(E), &value, sizeof(E));
+						}
+					}
+
+					count += values.size();
+					writer->set(0, &count, 4);
+				}
+
+				/// appends all values from the given range, see `putAll()`
+				template <std::forward_iterator I> requires accepts<std::iter_value_t<I>>
+				void putRange(I begin, I end) {
+					using V = std::iter_value_t<I>;
+
+					if constexpr (std::contiguous_iterator<I>) {
+						putAll(std::span<const V> {std::to_address(begin), (size_t) std::distance(begin, end)});
+					} else {
+						using E = typename T::type;
+						uint8_t* target = writer->extend(std::distance(begin, end) * sizeof(E));
+
+						for (; begin != end; begin ++) {
+							E value = static_cast<E>(*begin);
+							memcpy(target, &value, sizeof(E));
+							target += sizeof(E);
+							count ++;
+						}
+
+						writer->set(0, &count, 4);
+					}
+				}
+
+				/// marks the array as complete, in streaming mode it is written out right away
+				/// together with any nested values, so neither can be modified after this call
+				void close() {
+					manager->close(writer);
+				}
+
 		};
 
 	public:
@@ -40,7 +115,7 @@ class BinaryTreeArray {
 			private:
 
 				uint8_t node;
-				Reader reader;
+				R reader;
 				uint32_t remaining;
 				uint32_t stride;
 
@@ -52,7 +127,7 @@ class BinaryTreeArray {
 				using pointer = value_type*;
 				using reference = value_type&;
 
-				Iterator(Reader reader, uint32_t count, uint32_t stride, uint8_t node)
+				Iterator(R reader, uint32_t count, uint32_t stride, uint8_t node)
 				: reader(reader), remaining(count), stride(stride), node(node) {}
 
 				bool operator==(const Iterator& other) const {
@@ -64,7 +139,7 @@ class BinaryTreeArray {
 				}
 
 				value_type operator*() const {
-					if constexpr (std::is_same_v<T, BinaryTreeNode>) return {reader, node}; else return {reader}; // TODO
+					if constexpr (generic) return {reader, node}; else return {reader}; // TODO
 				}
 
 				// pre-increment
@@ -90,21 +165,25 @@ class BinaryTreeArray {
 		uint8_t node;
 		uint32_t stride;
 		uint32_t count;
-		Reader reader;
+		R reader;
 
 	public:
 
 		HEADER(BinaryNode::LIST);
 
-		BinaryTreeArray(Reader head)
+		using reader_type = R;
+
+		template <typename X>
+		using with = BinaryTreeArray<typename T::template with<X>>;
+
+		BinaryTreeArray(R head)
 		: reader(head) {
-			reader.jump(reader.read<uint32_t>());
-			count = reader.read<uint32_t>();
-			node = reader.read<uint8_t>();
+			reader.jump(reader.template read<uint32_t>(), BinaryNode::LIST);
+			count = reader.template read<uint32_t>();
+			node = reader.template read<uint8_t>();
 			stride = BinaryTreeNode::sizeOf(node);
 
-			// array can be templated with a BinaryTreeNode to iterate in a generic way
-			if constexpr (!std::is_same_v<T, BinaryTreeNode>) {
+			if constexpr (!generic) {
 				if (node != T::header) {
 					throw std::runtime_error {std::string {"Expected array type: "} + BinaryTreeNode::nameOf(T::header) + ", but got: " + BinaryTreeNode::nameOf(node)};
 				}
@@ -125,12 +204,60 @@ class BinaryTreeArray {
 			return BinaryTreeNode::nameOf(node);
 		}
 
+		/// returns a pointer to the first element, the elements are stored one after another
+		/// and aligned to `T::alignment`, so the array can be used in place without copying,
+		/// not available for data in the opposite byte order, use `copy()` there
+		template <typename V = T> requires requires { V::alignment; } && std::is_same_v<R, Reader>
+		const typename V::type* data() const {
+			return static_cast<const typename V::type*>(reader.ptr());
+		}
+
+		/// returns the elements as a span into the underlying data, that can be used in place without copying,
+		/// throws if they are not aligned, so the array needs to be written with `WriteConfig::array_alignment`
+		/// (arrays of vectors are always aligned), not available for data in the opposite byte order
+		template <typename V = T> requires requires { typename V::type; } && std::is_same_v<R, Reader>
+		std::span<const typename V::type> span() const {
+			using E = typename V::type;
+
+			if (reinterpret_cast<uintptr_t>(reader.ptr()) % alignof(E) != 0) {
+				throw std::runtime_error {"Array elements are not aligned, write the file with array alignment or use copy()"};
+			}
+
+			return {static_cast<const E*>(reader.ptr()), count};
+		}
+
+		/// copies up to `output.size()` elements into the output, converting them to the native byte
+		/// order if needed, the conversion is done in bulk, returns the number of elements copied
+		template <typename V = T> requires requires { typename V::type; }
+		size_t copy(std::span<typename V::type> output) const {
+			using E = typename V::type;
+			size_t elements = std::min<size_t>(output.size(), count);
+
+			if constexpr (std::is_same_v<R, Reader>) {
+				memcpy(output.data(), reader.ptr(), elements * sizeof(E));
+			} else if constexpr (std::is_arithmetic_v<E>) {
+				ByteSwap::bulk(output.data(), reader.ptr(), elements, sizeof(E));
+			} else {
+				ByteSwap::bulk(output.data(), reader.ptr(), elements * sizeof(E) / sizeof(typename E::value_type), sizeof(typename E::value_type));
+			}
+
+			return elements;
+		}
+
+		/// returns the element at the given index, the index is not checked
+		T at(uint32_t index) const {
+			R element {reader};
+			element.skip(stride * index);
+
+			if constexpr (generic) return {element, node}; else return {element};
+		}
+
 		Iterator begin() {
 			return {reader, count, stride, node};
 		}
 
 		Iterator end() {
-			Reader after {reader};
+			R after {reader};
 			after.skip(stride * count);
 			return {after, 0, stride, node};
 		}
@@ -0,0 +1,77 @@
+
+#pragma once
+#include <common/external.hpp>
+
+template <typename R>
+class BasicBinaryTreeBlob {
+
+	public:
+
+		class Writer {
+
+			private:
+
+				uint32_t length;
+
+			public:
+
+				SectionBuffer* writer;
+
+				/// the payload will be placed at a multiple of `alignment` in the
+				/// output, which needs to be a power of two not larger than 64
+				Writer(SectionManager* manager, SectionBuffer* buffer, uint32_t alignment = 1)
+				: length(0), writer(manager->allocate()) {
+					writer->write<uint32_t>(0);
+					writer->align(alignment, 4);
+					buffer->link(writer);
+				}
+
+				Writer(SectionManager* manager, SectionBuffer* buffer, std::span<const std::byte> value, uint32_t alignment = 1)
+				: Writer(manager, buffer, alignment) {
+					append(value);
+				}
+
+				Writer& append(std::span<const std::byte> value) {
+					writer->write(value.data(), value.size());
+					length += value.size();
+					writer->set(0, &length, 4);
+					return *this;
+				}
+
+		};
+
+	private:
+
+		uint32_t length;
+		R reader;
+
+	public:
+
+		HEADER(BinaryNode::BLOB);
+
+		using reader_type = R;
+
+		template <typename X>
+		using with = BasicBinaryTreeBlob<X>;
+
+		BasicBinaryTreeBlob(R head)
+		: reader(head) {
+			reader.jump(reader.template read<uint32_t>(), BinaryNode::BLOB);
+			length = reader.template read<uint32_t>();
+		}
+
+	public:
+
+		/// returns the payload, it points directly into the
+		/// underlying data and has the alignment requested by the writer
+		std::span<const std::byte> data() const {
+			return {static_cast<const std::byte*>(reader.ptr()), length};
+		}
+
+		size_t size() const {
+			return length;
+		}
+
+};
+
+using BinaryTreeBlob = BasicBinaryTreeBlob<Reader>;
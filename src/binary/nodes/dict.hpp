@@ -2,7 +2,8 @@
 #pragma once
 #include <common/external.hpp>
 
-class BinaryTreeDict {
+template <typename R>
+class BasicBinaryTreeDict {
 
 	public:
 
@@ -11,15 +12,45 @@ class BinaryTreeDict {
 			private:
 
 				uint8_t count;
+				bool indexed;
 				SectionManager* manager;
 				SectionBuffer* writer;
 
+				/// inserts the key into the sorted key column and the offset of the value, that
+				/// will be appended after all the previous values, into the offset column
+				void index(uint16_t key) {
+					const uint8_t* column = writer->bytes().data() + 1;
+					uint32_t position = 0;
+					uint16_t entry;
+
+					// equal keys are kept in insertion order, so that lookups find the first one
+					while (position < count && (memcpy(&entry, column + position * 2, 2), entry <= key)) {
+						position ++;
+					}
+
+					// all values move forward by the size of the new key and offset
+					for (uint32_t i = 0; i < count; i ++) {
+						memcpy(&entry, column + (count + i) * 2, 2);
+						entry += 4;
+						writer->set(1 + (count + i) * 2, &entry, 2);
+					}
+
+					uint16_t offset = writer->size() + 4;
+					writer->insert(1 + position * 2, &key, 2);
+					writer->insert(1 + (count + 1) * 2 + position * 2, &offset, 2);
+				}
+
 			public:
 
 				Writer(SectionManager* manager, SectionBuffer* buffer)
-				: count(0), manager(manager), writer(manager->allocate()) {
+				: count(0), indexed(manager->flags() & BinaryFlag::INDEXED_DICTS), manager(manager), writer(manager->allocate()) {
 					writer->write<uint8_t>(0);
 					buffer->link(writer);
+
+					// keep the key column aligned
+					if (indexed) {
+						writer->align(2, 1);
+					}
 				}
 
 				BinaryTreeNode::Writer put(uint16_t key) {
@@ -27,12 +58,23 @@ class BinaryTreeDict {
 						throw std::runtime_error {"Unable to add another key, maximum dictionary capacity reached"};
 					}
 
+					if (indexed) {
+						index(key);
+					} else {
+						writer->write<uint16_t>(key);
+					}
+
 					count ++;
 					writer->set(0, &count, 1);
-					writer->write<uint16_t>(key);
 					return {manager, writer};
 				}
 
+				/// marks the dictionary as complete, in streaming mode it is written out right away
+				/// together with any nested values, so neither can be modified after this call
+				void close() {
+					manager->close(writer);
+				}
+
 		};
 
 	public:
@@ -41,21 +83,29 @@ class BinaryTreeDict {
 
 			private:
 
-				Reader reader;
-				uint16_t key;
+				R reader;
 				uint32_t remaining;
 
+				// only used for indexed dictionaries, where the
+				// reader stays at the start of the key column
+				bool indexed = false;
+				uint32_t index = 0;
+				uint32_t count = 0;
+
 			public:
 
 				using iterator_category = std::forward_iterator_tag;
-				using value_type = std::pair<uint16_t, BinaryTreeNode>;
+				using value_type = std::pair<uint16_t, BasicBinaryTreeNode<R>>;
 				using difference_type = std::ptrdiff_t;
 				using pointer = value_type*;
 				using reference = value_type&;
 
-				Iterator(Reader reader, uint32_t count)
+				Iterator(R reader, uint32_t count)
 				: reader(reader), remaining(count) {}
 
+				Iterator(R reader, uint32_t count, uint32_t index)
+				: reader(reader), remaining(count - index), indexed(true), index(index), count(count) {}
+
 				bool operator==(const Iterator& other) const {
 					return remaining == other.remaining;
 				}
@@ -65,16 +115,24 @@ class BinaryTreeDict {
 				}
 
 				value_type operator*() const {
-					Reader value {reader};
-					uint16_t key = value.read<uint16_t>();
+					R value {reader};
+
+					if (indexed) {
+						return BasicBinaryTreeDict::entry(value, count, index);
+					}
+
+					uint16_t key = value.template read<uint16_t>();
 					return {key, value};
 				}
 
 				// pre-increment
 				Iterator& operator++() {
-					if (remaining > 0) {
+					if (indexed && remaining > 0) {
+						index ++;
+						remaining --;
+					} else if (remaining > 0) {
 						reader.skip(2);
-						reader.skip(BinaryTreeNode::sizeOf(reader.read<uint8_t>()));
+						reader.skip(BinaryTreeNode::sizeOf(reader.template read<uint8_t>()));
 						remaining --;
 					}
 					return *this;
@@ -92,16 +150,91 @@ class BinaryTreeDict {
 	private:
 
 		uint32_t count;
-		Reader reader;
+		R reader;
+
+		// set for dictionaries with a key column, `dense` is set if the key range
+		// starting at `first` matches the count, which means consecutive keys unless
+		// some are repeated, so `find()` checks the key it lands on
+		bool indexed;
+		bool dense = false;
+		uint16_t first = 0;
+
+		static uint16_t keyAt(const uint8_t* column, uint32_t index) {
+			return R::template load<uint16_t>(column + index * 2);
+		}
+
+		/// reads the entry at the given index of an indexed dictionary, the reader needs to point at the key column
+		static std::pair<uint16_t, BasicBinaryTreeNode<R>> entry(R reader, uint32_t count, uint32_t index) {
+			const uint8_t* column = static_cast<const uint8_t*>(reader.ptr());
+
+			// offsets are relative to the start of the section, one byte before the column
+			reader.skip(keyAt(column, count + index) - 1);
+			return {keyAt(column, index), reader};
+		}
+
+		/// returns the index of the first entry with the given key in an indexed dictionary, or -1 if there is none
+		int find(uint16_t key) const {
+			const uint8_t* column = static_cast<const uint8_t*>(reader.ptr());
+			uint32_t index = 0;
+
+			if (dense) {
+				index = (uint16_t) (key - first);
+
+				if (index >= count) {
+					return -1;
+				}
+
+				// duplicate keys leave gaps in a range that looks dense, so the guess is only
+				// used when it holds the first entry with the key, otherwise the column is scanned
+				if (keyAt(column, index) == key && (index == 0 || keyAt(column, index - 1) != key)) {
+					return index;
+				}
+
+				index = 0;
+			}
+
+#if defined(__SSE2__)
+			// the keys are compared in the byte order of the data
+			__m128i needle = _mm_set1_epi16(R::convert(key));
+
+			for (; index + 8 <= count; index += 8) {
+				__m128i keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + index * 2));
+				uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi16(keys, needle));
+
+				if (mask) {
+					return index + std::countr_zero(mask) / 2;
+				}
+			}
+#endif
+
+			for (; index < count; index ++) {
+				if (keyAt(column, index) == key) return index;
+			}
+
+			return -1;
+		}
 
 	public:
 
 		HEADER(BinaryNode::DICT);
 
-		BinaryTreeDict(Reader head)
+		using reader_type = R;
+
+		template <typename X>
+		using with = BasicBinaryTreeDict<X>;
+
+		BasicBinaryTreeDict(R head)
 		: reader(head) {
-			reader.jump(reader.read<uint32_t>());
-			count = reader.read<uint8_t>();
+			reader.jump(reader.template read<uint32_t>(), BinaryNode::DICT);
+			count = reader.template read<uint8_t>();
+			indexed = reader.flags() & BinaryFlag::INDEXED_DICTS;
+
+			// the keys are sorted, so if the range matches the count there are no gaps
+			if (indexed && count > 0) {
+				const uint8_t* column = static_cast<const uint8_t*>(reader.ptr());
+				first = keyAt(column, 0);
+				dense = (uint32_t) (keyAt(column, count - 1) - first) == count - 1;
+			}
 		}
 
 	public:
@@ -110,15 +243,24 @@ class BinaryTreeDict {
 			return count;
 		}
 
-		BinaryTreeNode get(uint16_t key) {
-			for (auto [entry, node] : *this) {
-				if (key == entry) return node;
+		BasicBinaryTreeNode<R> get(uint16_t key) {
+			if (indexed) {
+				int index = find(key);
+				if (index >= 0) return entry(reader, count, index).second;
+			} else {
+				for (auto [entry, node] : *this) {
+					if (key == entry) return node;
+				}
 			}
 
 			throw std::runtime_error {"Expected key: " + std::to_string(key) + ", but it was not found in the dictionary"};
 		}
 
 		bool has(uint16_t key) {
+			if (indexed) {
+				return find(key) >= 0;
+			}
+
 			for (auto [entry, node] : *this) {
 				if (key == entry) return true;
 			}
@@ -127,6 +269,10 @@ class BinaryTreeDict {
 		}
 
 		Iterator begin() {
+			if (indexed) {
+				return {reader, count, 0};
+			}
+
 			return {reader, count};
 		}
 
@@ -135,3 +281,5 @@ class BinaryTreeDict {
 		}
 
 };
+
+using BinaryTreeDict = BasicBinaryTreeDict<Reader>;
@@ -0,0 +1,210 @@
+
+#pragma once
+#include <common/external.hpp>
+
+/// a dictionary for large numbers of entries, the section holds the count, a link to
+/// the section with all the values and a column of [key][value offset] records sorted by key
+template <typename R>
+class BasicBinaryTreeMap {
+
+	public:
+
+		class Writer {
+
+			private:
+
+				uint32_t count;
+				SectionManager* manager;
+				SectionBuffer* writer;
+				SectionBuffer* values;
+
+			public:
+
+				Writer(SectionManager* manager, SectionBuffer* buffer)
+				: count(0), manager(manager), writer(manager->allocate()), values(manager->allocate()) {
+					writer->write<uint32_t>(0);
+					writer->link(values);
+					writer->index(8);
+					buffer->link(writer);
+				}
+
+				BinaryTreeNode::Writer put(uint16_t key) {
+					count ++;
+					writer->set(0, &count, 4);
+					writer->write<uint16_t>(key);
+					writer->write<uint32_t>(values->size());
+					return {manager, values};
+				}
+
+				/// marks the map as complete, in streaming mode it is written out right away
+				/// together with any nested values, so neither can be modified after this call
+				void close() {
+					manager->close(writer);
+				}
+
+		};
+
+	private:
+
+		static constexpr uint32_t stride = 6;
+
+		uint32_t count;
+		R reader; // points at the first record
+		R values;
+
+		// set if the key range starting at `first` matches the count, the keys are
+		// consecutive unless some are repeated, so `find()` checks the key it lands on
+		bool dense = false;
+		uint16_t first = 0;
+
+		const uint8_t* record(uint32_t index) const {
+			return static_cast<const uint8_t*>(reader.ptr()) + index * stride;
+		}
+
+		uint16_t keyAt(uint32_t index) const {
+			return R::template load<uint16_t>(record(index));
+		}
+
+		/// returns the index of the first record with the given key, or -1 if there is none
+		int64_t find(uint16_t key) const {
+			if (dense) {
+				uint32_t index = (uint16_t) (key - first);
+
+				if (index >= count) {
+					return -1;
+				}
+
+				// repeated keys can make a range with gaps look dense, so the
+				// guess is only used when it holds the first record with the key
+				if (keyAt(index) == key && (index == 0 || keyAt(index - 1) != key)) {
+					return index;
+				}
+			}
+
+			uint32_t low = 0;
+			uint32_t high = count;
+
+			while (low < high) {
+				uint32_t middle = low + (high - low) / 2;
+
+				if (keyAt(middle) < key) {
+					low = middle + 1;
+				} else {
+					high = middle;
+				}
+			}
+
+			return (low < count && keyAt(low) == key) ? (int64_t) low : -1;
+		}
+
+	public:
+
+		class Iterator {
+
+			private:
+
+				const BasicBinaryTreeMap* map;
+				uint32_t index;
+
+			public:
+
+				using iterator_category = std::forward_iterator_tag;
+				using value_type = std::pair<uint16_t, BasicBinaryTreeNode<R>>;
+				using difference_type = std::ptrdiff_t;
+				using pointer = value_type*;
+				using reference = value_type&;
+
+				Iterator(const BasicBinaryTreeMap* map, uint32_t index)
+				: map(map), index(index) {}
+
+				bool operator==(const Iterator& other) const {
+					return index == other.index;
+				}
+
+				bool operator!=(const Iterator& other) const {
+					return !(*this == other);
+				}
+
+				value_type operator*() const {
+					return {map->keyAt(index), map->at(index)};
+				}
+
+				// pre-increment
+				Iterator& operator++() {
+					index ++;
+					return *this;
+				}
+
+				// post-increment
+				Iterator operator++(int) {
+					Iterator tmp = *this;
+					++(*this);
+					return tmp;
+				}
+
+		};
+
+	public:
+
+		HEADER(BinaryNode::MAP);
+
+		using reader_type = R;
+
+		template <typename X>
+		using with = BasicBinaryTreeMap<X>;
+
+		BasicBinaryTreeMap(R head)
+		: reader(head) {
+			reader.jump(reader.template read<uint32_t>(), BinaryNode::MAP);
+			count = reader.template read<uint32_t>();
+
+			values = reader;
+			values.jump(reader.template read<uint32_t>(), BinarySection::VALUES);
+
+			// the keys are sorted, so if the range matches the count there are no gaps
+			if (count > 0) {
+				first = keyAt(0);
+				dense = (uint32_t) (keyAt(count - 1) - first) == count - 1;
+			}
+		}
+
+	public:
+
+		int size() const {
+			return count;
+		}
+
+		/// returns the value of the record at the given index, records are ordered by key
+		BasicBinaryTreeNode<R> at(uint32_t index) const {
+			uint32_t offset = R::template load<uint32_t>(record(index) + 2);
+
+			R value {values};
+			value.skip(offset);
+			return {value};
+		}
+
+		BasicBinaryTreeNode<R> get(uint16_t key) const {
+			int64_t index = find(key);
+
+			if (index < 0) {
+				throw std::runtime_error {"Expected key: " + std::to_string(key) + ", but it was not found in the map"};
+			}
+
+			return at(index);
+		}
+
+		bool has(uint16_t key) const {
+			return find(key) >= 0;
+		}
+
+		Iterator begin() const {
+			return {this, 0};
+		}
+
+		Iterator end() const {
+			return {this, count};
+		}
+
+};
+
+using BinaryTreeMap = BasicBinaryTreeMap<Reader>;
@@ -2,7 +2,11 @@
 #pragma once
 #include <common/external.hpp>
 
-class BinaryTreeNode {
+/// a node of any type, `R` is the reader used for all the values and nodes
+/// reached from this one, see `SwappedReader`, the nodes returned by `as()`
+/// use the same reader, so generic code doesn't need to spell it out
+template <typename R>
+class BasicBinaryTreeNode {
 
 	public:
 
@@ -24,25 +28,38 @@ class BinaryTreeNode {
 					return {manager, buffer, args...};
 				}
 
+				/// writes the type and payload of the node verbatim, so the links in the payload keep pointing to the
+				/// old sections, only valid if the output is appended to the file the node was read from, the
+				/// editor checks that with `BinaryTreeEditor::link()`, which should be used instead
+				inline void reuse(BasicBinaryTreeNode node) {
+					buffer->write<uint8_t>(node.type());
+					buffer->write(node.data(), sizeOf(node.type()));
+				}
+
 		};
 
 	public:
 
+		using reader_type = R;
+
+		template <typename X>
+		using with = BasicBinaryTreeNode<X>;
+
 		static constexpr const char* nameOf(uint8_t node);
 		static constexpr uint32_t sizeOf(uint8_t node);
 
 	private:
 
 		uint8_t node;
-		Reader reader;
+		R reader;
 
 	public:
 
-		BinaryTreeNode(Reader reader, uint8_t node)
+		BasicBinaryTreeNode(R reader, uint8_t node)
 		: node(node), reader(reader) {}
 
-		BinaryTreeNode(Reader reader)
-		: node(reader.read<uint8_t>()), reader(reader) {}
+		BasicBinaryTreeNode(R reader)
+		: node(reader.template read<uint8_t>()), reader(reader) {}
 
 		template <typename T>
 		inline bool is() {
@@ -50,7 +67,7 @@ class BinaryTreeNode {
 		}
 
 		template <typename T>
-		inline T as() {
+		inline typename T::template with<R> as() {
 			if (!is<T>()) throw std::runtime_error {std::string {"Expected node type: "} + nameOf(T::header) + ", but got: " + nameOf(node)};
 			return {reader};
 		}
@@ -63,4 +80,11 @@ class BinaryTreeNode {
 			return nameOf(node);
 		}
 
+		/// returns a pointer to the payload of this node, that follows the type byte
+		inline const void* data() const {
+			return reader.ptr();
+		}
+
 };
+
+using BinaryTreeNode = BasicBinaryTreeNode<Reader>;
@@ -2,7 +2,7 @@
 #pragma once
 #include <common/external.hpp>
 
-template <typename T>
+template <typename T, typename R = Reader>
 class BinaryTreePrimitive {
 
 	public:
@@ -36,8 +36,11 @@ class BinaryTreePrimitive {
 
 	public:
 
-		BinaryTreePrimitive(Reader reader)
-		: value(reader.read<T>()) {}
+		using type = T;
+		using reader_type = R;
+
+		BinaryTreePrimitive(R reader)
+		: value(reader.template read<T>()) {}
 
 		operator T() const {
 			return value;
@@ -45,9 +48,9 @@ class BinaryTreePrimitive {
 
 };
 
-#define DefineTypeAdapter(name, type, node) struct name : public BinaryTreePrimitive<type> { \
-	HEADER(node); name(Reader reader) : BinaryTreePrimitive(reader) {} \
-}
+#define DefineTypeAdapter(name, type, node) template <typename R> struct Basic##name : public BinaryTreePrimitive<type, R> { \
+	HEADER(node); template <typename X> using with = Basic##name<X>; Basic##name(R reader) : BinaryTreePrimitive<type, R>(reader) {} \
+}; using name = Basic##name<Reader>
 
 DefineTypeAdapter(BinaryTreeDouble, double, BinaryNode::DOUBLE);
 DefineTypeAdapter(BinaryTreeFloat, float, BinaryNode::FLOAT);
@@ -2,19 +2,31 @@
 #pragma once
 #include <common/external.hpp>
 
-class BinaryTreeText {
+template <typename R>
+class BasicBinaryTreeText {
 
 	public:
 
 		class Writer {
 
+			private:
+
+				uint32_t length;
+				bool sized;
+
 			public:
 
 				SectionBuffer* writer;
 
 				Writer(SectionManager* manager, SectionBuffer* buffer)
-				: writer(manager->allocate()) {
+				: length(0), sized(manager->flags() & BinaryFlag::SIZED_TEXT), writer(manager->allocate()) {
 					buffer->link(writer);
+
+					if (sized) {
+						writer->write<uint32_t>(0);
+					}
+
+					writer->write<uint8_t>(0);
 				}
 
 				Writer(SectionManager* manager, SectionBuffer* buffer, std::string_view value)
@@ -26,6 +38,12 @@ class BinaryTreeText {
 					writer->pop();
 					writer->write(value.data(), value.size());
 					writer->write<uint8_t>(0);
+					length += value.size();
+
+					if (sized) {
+						writer->set(0, &length, 4);
+					}
+
 					return *this;
 				}
 
@@ -33,29 +51,56 @@ class BinaryTreeText {
 
 	private:
 
-		Reader reader;
+		R reader;
+
+		// only set for sized texts, otherwise the
+		// length is found by searching for the terminator
+		bool sized = false;
+		uint32_t length = 0;
 
 	public:
 
 		HEADER(BinaryNode::TEXT);
 
-		BinaryTreeText(Reader head)
+		using reader_type = R;
+
+		template <typename X>
+		using with = BasicBinaryTreeText<X>;
+
+		BasicBinaryTreeText(R head)
 		: reader(head) {
-			reader.jump(reader.read<uint32_t>());
+			reader.jump(reader.template read<uint32_t>(), BinaryNode::TEXT);
+
+			if (reader.flags() & BinaryFlag::SIZED_TEXT) {
+				sized = true;
+				length = reader.template read<uint32_t>();
+			}
 		}
 
 	public:
 
+		/// returns the text, it is always followed by a zero byte, but for
+		/// sized texts it can also contain zeros, use `size()` or `view()` then
 		const char* data() const {
 			return reinterpret_cast<const char*>(reader.ptr());
 		}
 
+		size_t size() const {
+			return sized ? length : strlen(data());
+		}
+
 		std::string_view view() const {
-			return {data()};
+			return {data(), size()};
 		}
 
 		std::string copy() const {
-			return {data()};
+			return {data(), size()};
+		}
+
+		bool operator==(std::string_view other) const {
+			return view() == other;
 		}
 
 };
+
+using BinaryTreeText = BasicBinaryTreeText<Reader>;
@@ -0,0 +1,96 @@
+
+#pragma once
+#include <common/external.hpp>
+
+/// a fixed size group of `N` values, laid out
+/// exactly like `T[N]` without any padding
+template <typename T, size_t N>
+struct BinaryVector {
+
+	using value_type = T;
+
+	T values[N];
+
+	constexpr T& operator[](size_t index) {
+		return values[index];
+	}
+
+	constexpr const T& operator[](size_t index) const {
+		return values[index];
+	}
+
+	static constexpr size_t size() {
+		return N;
+	}
+
+	bool operator==(const BinaryVector& other) const = default;
+
+};
+
+template <typename T, size_t N, typename R = Reader>
+class BinaryTreeVector {
+
+	public:
+
+		using type = BinaryVector<T, N>;
+		using reader_type = R;
+
+		// arrays of vectors are written so that the first element lands at this alignment,
+		// which lets them be passed to SIMD code straight from the mapped file
+		static constexpr uint32_t alignment = std::min<size_t>(std::bit_ceil(sizeof(type)), 16);
+
+		class Writer {
+
+			public:
+
+				Writer(SectionManager*, SectionBuffer* buffer, const type& value) {
+					buffer->write<type>(value);
+				}
+
+				template <typename... A> requires (sizeof...(A) == N) && (std::is_arithmetic_v<A> && ...)
+				Writer(SectionManager* manager, SectionBuffer* buffer, A... values)
+				: Writer(manager, buffer, type {static_cast<T>(values)...}) {}
+
+		};
+
+	private:
+
+		type value;
+
+	public:
+
+		// the components are read one by one, so that each can be swapped if needed
+		BinaryTreeVector(R reader) {
+			for (size_t i = 0; i < N; i ++) {
+				value[i] = reader.template read<T>();
+			}
+		}
+
+		operator type() const {
+			return value;
+		}
+
+		T operator[](size_t index) const {
+			return value[index];
+		}
+
+		static constexpr size_t size() {
+			return N;
+		}
+
+};
+
+#define DefineVectorAdapter(name, type, count, node) template <typename R> struct Basic##name : public BinaryTreeVector<type, count, R> { \
+	HEADER(node); template <typename X> using with = Basic##name<X>; Basic##name(R reader) : BinaryTreeVector<type, count, R>(reader) {} \
+}; using name = Basic##name<Reader>
+
+DefineVectorAdapter(BinaryTreeVec2f, float, 2, BinaryNode::VEC2F);
+DefineVectorAdapter(BinaryTreeVec3f, float, 3, BinaryNode::VEC3F);
+DefineVectorAdapter(BinaryTreeVec2i, int32_t, 2, BinaryNode::VEC2I);
+DefineVectorAdapter(BinaryTreeVec3i, int32_t, 3, BinaryNode::VEC3I);
+DefineVectorAdapter(BinaryTreeVec2s, int16_t, 2, BinaryNode::VEC2S);
+DefineVectorAdapter(BinaryTreeVec3s, int16_t, 3, BinaryNode::VEC3S);
+DefineVectorAdapter(BinaryTreeVec4s, int16_t, 4, BinaryNode::VEC4S);
+DefineVectorAdapter(BinaryTreeVec2b, int8_t, 2, BinaryNode::VEC2B);
+DefineVectorAdapter(BinaryTreeVec3b, int8_t, 3, BinaryNode::VEC3B);
+DefineVectorAdapter(BinaryTreeVec4b, int8_t, 4, BinaryNode::VEC4B);
@@ -0,0 +1,300 @@
+
+#include "paged.hpp"
+#include "header.hpp"
+#include "nodes.hpp"
+
+PagedSource::PagedSource(const std::string& path, const PagedConfig& config)
+: file(path), config(config) {
+
+	if (config.page_size == 0 || config.page_size % 64 != 0) {
+		throw std::runtime_error {"Page size needs to be a non-zero multiple of 64"};
+	}
+
+	if (file.size() < BinaryTreeHeader::size) {
+		throw std::runtime_error {"File is too short to contain the header"};
+	}
+
+	uint8_t bytes[BinaryTreeHeader::size];
+	file.read(0, bytes, BinaryTreeHeader::size);
+
+	Reader reader {bytes};
+	BinaryTreeHeader header {reader};
+
+	this->flags = header.flags;
+	this->swapped = header.swapped();
+}
+
+PagedSource::Page PagedSource::fetch(uint64_t offset, size_t size) {
+	constexpr size_t alignment = 64;
+
+	Page page;
+	page.memory = std::make_unique_for_overwrite<uint8_t[]>(size + alignment);
+	page.size = size;
+
+	uintptr_t base = (uintptr_t) page.memory.get();
+	size_t shift = (offset - base) & (alignment - 1);
+
+	page.data = page.memory.get() + shift;
+	file.read(offset, page.memory.get() + shift, size);
+
+	resident += size;
+	return page;
+}
+
+PagedSource::Page& PagedSource::page(uint64_t index) {
+	auto it = pages.find(index);
+
+	if (it == pages.end()) {
+		uint64_t offset = index * config.page_size;
+		it = pages.emplace(index, fetch(offset, std::min<uint64_t>(config.page_size, file.size() - offset))).first;
+	}
+
+	it->second.used = ++ clock;
+	return it->second;
+}
+
+template <typename T>
+T PagedSource::load(uint64_t offset) {
+	T value {};
+
+	if (offset + sizeof(T) > file.size()) {
+		return value;
+	}
+
+	uint64_t index = offset / config.page_size;
+	size_t at = offset % config.page_size;
+
+	if (at + sizeof(T) > config.page_size) {
+		read(offset, &value, sizeof(T));
+	} else {
+		if (index != last) {
+			cached = page(index).data;
+			last = index;
+		}
+
+		memcpy(&value, cached + at, sizeof(T));
+	}
+
+	if constexpr (sizeof(T) > 1) {
+		return swapped ? ByteSwap::value(value) : value;
+	}
+
+	return value;
+}
+
+size_t PagedSource::measure(uint32_t offset, uint8_t type) {
+	uint64_t limit = file.size();
+	uint64_t end = offset;
+
+	if (offset >= limit) {
+		return 0;
+	}
+
+	switch (type) {
+
+		case BinarySection::SLOT:
+			end = offset + 1 + BinaryTreeNode::sizeOf(load<uint8_t>(offset));
+			break;
+
+		case BinarySection::TABLE:
+			end = offset + 12 + (uint64_t) load<uint32_t>(offset + 4) * 4;
+			break;
+
+		case BinarySection::VALUES: {
+			auto it = reach.find(offset);
+			end = it == reach.end() ? offset : it->second;
+			break;
+		}
+
+		case BinaryNode::DICT: {
+			uint8_t count = load<uint8_t>(offset);
+
+			if (flags & BinaryFlag::INDEXED_DICTS) {
+				end = offset + 1 + count * 4;
+
+				// the values are in insertion order, so the last one isn't always at the end
+				for (uint32_t i = 0; i < count; i ++) {
+					uint64_t value = offset + load<uint16_t>(offset + 1 + (count + i) * 2);
+					end = std::max<uint64_t>(end, value + 1 + BinaryTreeNode::sizeOf(load<uint8_t>(value)));
+				}
+			} else {
+				end = offset + 1;
+
+				for (uint32_t i = 0; i < count && end < limit; i ++) {
+					end += 3 + BinaryTreeNode::sizeOf(load<uint8_t>(end + 2));
+				}
+			}
+
+			break;
+		}
+
+		case BinaryNode::MAP:
+			end = offset + 8 + (uint64_t) load<uint32_t>(offset) * 6;
+			break;
+
+		case BinaryNode::LIST:
+			end = offset + 5 + (uint64_t) load<uint32_t>(offset) * BinaryTreeNode::sizeOf(load<uint8_t>(offset + 4));
+			break;
+
+		case BinaryNode::TEXT:
+			if (flags & BinaryFlag::SIZED_TEXT) {
+				end = offset + 4 + (uint64_t) load<uint32_t>(offset) + 1;
+				break;
+			}
+
+			// look for the terminator one page at a time
+			while (end < limit) {
+				Page& current = page(end / config.page_size);
+				const uint8_t* start = current.data + end % config.page_size;
+				const uint8_t* zero = (const uint8_t*) memchr(start, 0, current.size - end % config.page_size);
+
+				if (zero) {
+					end += zero - start + 1;
+					break;
+				}
+
+				end += current.size - end % config.page_size;
+			}
+
+			break;
+
+		case BinaryNode::BLOB:
+			end = offset + 4 + (uint64_t) load<uint32_t>(offset);
+			break;
+
+		default:
+			throw std::runtime_error {"Unable to measure section at offset " + std::to_string(offset) + ", unknown type " + std::to_string(type)};
+
+	}
+
+	return std::min(end, limit) - offset;
+}
+
+size_t PagedSource::size() const {
+	return file.size();
+}
+
+void PagedSource::read(uint64_t offset, void* buffer, size_t size) {
+	if (offset > file.size() || size > file.size() - offset) {
+		throw std::runtime_error {"Offset " + std::to_string(offset) + " lies outside of the file"};
+	}
+
+	uint8_t* output = static_cast<uint8_t*>(buffer);
+
+	while (size > 0) {
+		Page& current = page(offset / config.page_size);
+		size_t at = offset % config.page_size;
+		size_t count = std::min(size, current.size - at);
+
+		memcpy(output, current.data + at, count);
+		output += count;
+		offset += count;
+		size -= count;
+	}
+}
+
+const uint8_t* PagedSource::resolve(uint32_t offset, uint8_t type) {
+	size_t size = measure(offset, type);
+
+	if (size == 0) {
+		static constexpr uint8_t nothing = 0;
+
+		// the values of an empty map take no space, they can even start at the end of the file
+		if (type == BinarySection::VALUES && reach.contains(offset)) {
+			return &nothing;
+		}
+
+		if (type == BinarySection::VALUES && offset < file.size()) {
+			throw std::runtime_error {"Map values at offset " + std::to_string(offset) + " can only be read after their map"};
+		}
+
+		throw std::runtime_error {"Offset " + std::to_string(offset) + " lies outside of the file"};
+	}
+
+	const uint8_t* data;
+	uint64_t index = offset / config.page_size;
+
+	if ((offset + size - 1) / config.page_size == index) {
+		data = page(index).data + offset % config.page_size;
+	} else {
+		uint64_t key = (uint64_t) type << 32 | offset;
+		auto it = sections.find(key);
+
+		// map values can grow when a map that shares them reaches further, the old
+		// buffer could still be in use, so it is only released by the next `trim()`
+		if (it != sections.end() && it->second.size < size) {
+			retired.push_back(std::move(it->second));
+			sections.erase(it);
+			it = sections.end();
+		}
+
+		if (it == sections.end()) {
+			it = sections.emplace(key, fetch(offset, size)).first;
+		}
+
+		it->second.used = ++ clock;
+		data = it->second.data;
+	}
+
+	// the values of a map are addressed relative to their offset, so their end can only be found from the records,
+	// the value slots are at most 16 bytes long, so that is used as their size, to avoid reading all their types
+	if (type == BinaryNode::MAP && size >= 8 && maps.insert(offset).second) {
+		auto word = [&] (size_t at) {
+			uint32_t value = Reader::load<uint32_t>(data + at);
+			return swapped ? ByteSwap::value(value) : value;
+		};
+
+		uint32_t values = word(4);
+		uint64_t count = std::min<uint64_t>(word(0), (size - 8) / 6);
+		uint64_t& end = reach[values];
+		end = std::max<uint64_t>(end, values);
+
+		for (uint64_t i = 0; i < count; i ++) {
+			end = std::max<uint64_t>(end, (uint64_t) values + word(8 + i * 6 + 2) + 16);
+		}
+	}
+
+	return data;
+}
+
+size_t PagedSource::extent(uint32_t offset, uint8_t type) {
+	return measure(offset, type);
+}
+
+void PagedSource::trim() {
+	for (Page& page : retired) {
+		resident -= page.size;
+	}
+
+	retired.clear();
+	last = UINT64_MAX;
+
+	if (resident <= config.cache_size) {
+		return;
+	}
+
+	// pages and sections are evicted together, oldest first
+	std::vector<std::tuple<uint64_t, bool, uint64_t>> loaded;
+
+	for (auto& [index, page] : pages) {
+		loaded.emplace_back(page.used, false, index);
+	}
+
+	for (auto& [key, section] : sections) {
+		loaded.emplace_back(section.used, true, key);
+	}
+
+	std::sort(loaded.begin(), loaded.end());
+
+	for (auto [used, section, key] : loaded) {
+		if (resident <= config.cache_size) {
+			break;
+		}
+
+		auto& table = section ? sections : pages;
+		auto it = table.find(key);
+
+		resident -= it->second.size;
+		table.erase(it);
+	}
+}
@@ -0,0 +1,97 @@
+
+#pragma once
+#include <common/external.hpp>
+#include <common/file.hpp>
+
+#include "reader.hpp"
+
+struct PagedConfig {
+
+	// the size of each read and cached page in bytes, needs to be a multiple of 64
+	size_t page_size = 64 * 1024;
+
+	// the number of bytes kept by `trim()`, counting both the
+	// pages and the sections that were read on their own
+	size_t cache_size = 64 * 1024 * 1024;
+
+};
+
+/// reads a file with positional reads instead of mapping it, the recently used parts are kept in a bounded cache,
+/// each section is measured first using the type it was reached with, sections within one page are returned from
+/// the cached page, and the ones that cross a page boundary are read into a buffer of their own, so that the
+/// readers see them as contiguous, like with `BlockCache` the memory is only released by `trim()`, which is
+/// called by `BinaryTree::Input` on each `root()` and `read()`, and by the validator after each section, so
+/// the only case where the cache grows without bound is a single long traversal of the nodes of one root
+class PagedSource : public SectionSource {
+
+	private:
+
+		struct Page {
+			std::unique_ptr<uint8_t[]> memory;
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+			uint64_t used = 0;
+		};
+
+		RandomFile file;
+		PagedConfig config;
+
+		// the layout of the file, from its header
+		uint16_t flags;
+		bool swapped;
+
+		// pages by their index, and sections that cross a page boundary by their type and offset
+		std::unordered_map<uint64_t, Page> pages;
+		std::unordered_map<uint64_t, Page> sections;
+
+		// sections replaced by larger ones, kept until the next `trim()`
+		std::vector<Page> retired;
+
+		// the end of the furthest value of each map, by the offset of its values, the values are
+		// addressed relative to that offset, so they can't be measured alone, `maps` holds the
+		// offsets of the maps already counted, both have one entry for each map that was read
+		std::unordered_map<uint32_t, uint64_t> reach;
+		std::unordered_set<uint32_t> maps;
+
+		// the page used by the last `load()`, values of one section are usually read together
+		uint64_t last = UINT64_MAX;
+		const uint8_t* cached = nullptr;
+
+		size_t resident = 0;
+		uint64_t clock = 0;
+
+		/// reads the range into a new buffer, placed so that it keeps the alignment it has within the file
+		Page fetch(uint64_t offset, size_t size);
+
+		/// returns the page with the given index, reading it if it is not cached
+		Page& page(uint64_t index);
+
+		/// reads the value at the offset through the page cache, zero past the end of the file
+		template <typename T>
+		T load(uint64_t offset);
+
+		/// returns the size of the section at the offset, clamped to the end of the file
+		size_t measure(uint32_t offset, uint8_t type);
+
+	public:
+
+		/// opens the file and reads the header, which sets the layout used to measure the sections
+		PagedSource(const std::string& path, const PagedConfig& config = {});
+
+		size_t size() const;
+
+		/// copies `size` bytes starting at the offset into the buffer, the range needs to lie within the file
+		void read(uint64_t offset, void* buffer, size_t size);
+
+		/// returns a pointer to the section at the offset, reading it if needed, map values can only be
+		/// resolved after the map itself, as the offsets of its records are needed to find their end
+		const uint8_t* resolve(uint32_t offset, uint8_t type) override;
+
+		/// returns the size of the section at the offset, zero if it lies outside of the file
+		size_t extent(uint32_t offset, uint8_t type) override;
+
+		/// drops the least recently used pages and sections over the cache size, this
+		/// invalidates all the readers and node views created from data in them
+		void trim() override;
+
+};
@@ -0,0 +1,145 @@
+
+#include "prefetch.hpp"
+#include "nodes.hpp"
+
+BinaryTreePrefetcher::BinaryTreePrefetcher(InputFile& file, uint16_t flags, bool swapped)
+: file(file), flags(flags), swapped(swapped) {}
+
+void BinaryTreePrefetcher::value(uint8_t type, uint64_t payload) {
+	if (type != BinaryNode::DICT && type != BinaryNode::LIST && type != BinaryNode::TEXT && type != BinaryNode::BLOB && type != BinaryNode::MAP) {
+		return;
+	}
+
+	uint32_t offset;
+
+	// identical sections are shared, so each one only needs to be walked once
+	if (load(payload, offset) && visited.insert((uint64_t) offset << 8 | type).second) {
+		stack.push_back({offset, type});
+	}
+}
+
+void BinaryTreePrefetcher::range(uint64_t start, uint64_t end) {
+	ranges.push_back({start, std::min<uint64_t>(end, file.size())});
+
+	if (ranges.size() >= 4096) {
+		flush();
+	}
+}
+
+void BinaryTreePrefetcher::flush() {
+	std::sort(ranges.begin(), ranges.end(), [] (const Range& a, const Range& b) {
+		return a.start < b.start;
+	});
+
+	for (size_t i = 0; i < ranges.size(); ) {
+		Range merged = ranges[i ++];
+
+		while (i < ranges.size() && ranges[i].start <= merged.end + gap) {
+			merged.end = std::max(merged.end, ranges[i ++].end);
+		}
+
+		file.advise(merged.start, merged.end - merged.start, InputAdvice::WILLNEED);
+	}
+
+	ranges.clear();
+}
+
+void BinaryTreePrefetcher::run(uint8_t type, uint64_t payload) {
+	value(type, payload);
+
+	while (!stack.empty() && !stopped) {
+		auto [offset, type] = stack.back();
+		stack.pop_back();
+
+		if (type == BinaryNode::DICT) {
+			uint8_t count;
+			if (!load(offset, count)) continue;
+
+			if (flags & BinaryFlag::INDEXED_DICTS) {
+				uint64_t end = offset + 1 + count * 4;
+
+				for (uint32_t i = 0; i < count; i ++) {
+					uint16_t at;
+					uint8_t node;
+
+					if (load(offset + 1 + (count + i) * 2, at) && load(offset + at, node)) {
+						value(node, offset + at + 1);
+						end = std::max<uint64_t>(end, offset + at + 1 + BinaryTreeNode::sizeOf(node));
+					}
+				}
+
+				range(offset, end);
+				continue;
+			}
+
+			uint64_t entry = offset + 1;
+
+			for (uint32_t i = 0; i < count; i ++) {
+				uint8_t node;
+				if (!load(entry + 2, node)) break;
+
+				value(node, entry + 3);
+				entry += 3 + BinaryTreeNode::sizeOf(node);
+			}
+
+			range(offset, entry);
+			continue;
+		}
+
+		if (type == BinaryNode::MAP) {
+			uint32_t count, values;
+			if (!load(offset, count) || !load(offset + 4, values)) continue;
+
+			uint64_t end = values;
+
+			for (uint32_t i = 0; i < count && !stopped; i ++) {
+				uint32_t at;
+				uint8_t node;
+
+				if (load(offset + 8 + i * 6 + 2, at) && load((uint64_t) values + at, node)) {
+					value(node, (uint64_t) values + at + 1);
+					end = std::max<uint64_t>(end, (uint64_t) values + at + 1 + BinaryTreeNode::sizeOf(node));
+				}
+			}
+
+			range(offset, offset + 8 + (uint64_t) count * 6);
+			range(values, end);
+			continue;
+		}
+
+		if (type == BinaryNode::LIST) {
+			uint32_t count;
+			uint8_t node;
+			if (!load(offset, count) || !load(offset + 4, node)) continue;
+
+			uint32_t stride = BinaryTreeNode::sizeOf(node);
+
+			for (uint64_t i = 0; i < count && !stopped; i ++) {
+				if (offset + 5 + (i + 1) * stride > file.size()) break;
+				value(node, offset + 5 + i * stride);
+			}
+
+			range(offset, offset + 5 + (uint64_t) count * stride);
+			continue;
+		}
+
+		if (type == BinaryNode::BLOB || (type == BinaryNode::TEXT && (flags & BinaryFlag::SIZED_TEXT))) {
+			uint32_t length;
+			if (!load(offset, length)) continue;
+
+			range(offset, offset + 5 + (uint64_t) length);
+			continue;
+		}
+
+		// the length of other texts is only known once they are read, so just their start is requested
+		if (type == BinaryNode::TEXT) {
+			range(offset, offset + 1);
+		}
+	}
+
+	flush();
+}
+
+void BinaryTreePrefetcher::stop() {
+	stopped = true;
+}
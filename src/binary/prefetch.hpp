@@ -0,0 +1,66 @@
+
+#pragma once
+#include <common/external.hpp>
+#include <common/file.hpp>
+
+#include "swap.hpp"
+
+/// walks the sections reachable from a node and asks the system to load them ahead of use, this is meant
+/// to run on a background thread, the data is not trusted, so links outside the file are simply skipped
+class BinaryTreePrefetcher {
+
+	private:
+
+		struct Range {
+			uint64_t start;
+			uint64_t end;
+		};
+
+		InputFile& file;
+		uint16_t flags;
+		bool swapped;
+
+		std::vector<std::pair<uint32_t, uint8_t>> stack;
+		std::unordered_set<uint64_t> visited;
+		std::vector<Range> ranges;
+		std::atomic<bool> stopped {false};
+
+		// ranges closer than this are merged into one hint
+		static constexpr uint64_t gap = 64 * 1024;
+
+		/// reads the value at the given offset, returns false if it doesn't fit in the file
+		template <typename T>
+		bool load(uint64_t offset, T& value) const {
+			if (offset + sizeof(T) > file.size()) {
+				return false;
+			}
+
+			memcpy(&value, file.data() + offset, sizeof(T));
+
+			if (swapped) {
+				value = ByteSwap::value(value);
+			}
+
+			return true;
+		}
+
+		/// pushes the section linked from the payload of a compound node
+		void value(uint8_t type, uint64_t payload);
+
+		/// adds the range of a section, the ranges are passed to the system in batches
+		void range(uint64_t start, uint64_t end);
+
+		/// merges the collected ranges and passes them to the system
+		void flush();
+
+	public:
+
+		BinaryTreePrefetcher(InputFile& file, uint16_t flags, bool swapped);
+
+		/// prefetches the node of the given type whose payload starts at the offset
+		void run(uint8_t type, uint64_t payload);
+
+		/// makes a running `run()` return as soon as possible, can be called from any thread
+		void stop();
+
+};
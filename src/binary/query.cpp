@@ -0,0 +1,166 @@
+
+#include "query.hpp"
+
+/// calls `function` for each node selected by the step from the given node
+template <typename R, typename F>
+static void select(const BinaryTreeQuery::Step& step, BasicBinaryTreeNode<R> node, F function) {
+	using Step = BinaryTreeQuery::Step;
+
+	if (node.template is<BinaryTreeDict>()) {
+		auto dict = node.template as<BinaryTreeDict>();
+
+		if (step.kind == Step::KEY && dict.has(step.value)) {
+			function(dict.get(step.value));
+		}
+
+		if (step.kind == Step::ALL) {
+			for (auto [key, value] : dict) function(value);
+		}
+
+		return;
+	}
+
+	if (node.template is<BinaryTreeMap>()) {
+		auto map = node.template as<BinaryTreeMap>();
+
+		if (step.kind == Step::KEY && map.has(step.value)) {
+			function(map.get(step.value));
+		}
+
+		if (step.kind == Step::ALL) {
+			for (auto [key, value] : map) function(value);
+		}
+
+		return;
+	}
+
+	if (node.type() == BinaryNode::LIST) {
+		auto array = node.template as<BinaryTreeArray<BinaryTreeNode>>();
+
+		if (step.kind == Step::INDEX && step.value < (uint32_t) array.size()) {
+			function(array.at(step.value));
+		}
+
+		if (step.kind == Step::ALL) {
+			for (auto value : array) function(value);
+		}
+	}
+}
+
+/*
+ * BinaryTreeQuery
+ */
+
+BinaryTreeQuery::BinaryTreeQuery(std::string_view path) {
+
+	auto invalid = [&] (std::string_view segment) {
+		return std::runtime_error {"Invalid segment '" + std::string {segment} + "' in query '" + std::string {path} + "'"};
+	};
+
+	// parses a decimal number that takes up the whole text
+	auto number = [&] (std::string_view segment, std::string_view text, uint32_t limit) -> uint32_t {
+		uint64_t value = 0;
+
+		if (text.empty() || text.size() > 10) {
+			throw invalid(segment);
+		}
+
+		for (char digit : text) {
+			if (digit < '0' || digit > '9') throw invalid(segment);
+			value = value * 10 + (digit - '0');
+		}
+
+		if (value > limit) {
+			throw invalid(segment);
+		}
+
+		return value;
+	};
+
+	for (auto part : path | std::views::split('/')) {
+		std::string_view segment {part.begin(), part.end()};
+
+		// allow leading, trailing and doubled slashes
+		if (segment.empty()) {
+			continue;
+		}
+
+		if (segment == "*") {
+			steps.push_back({Step::ALL, 0});
+			continue;
+		}
+
+		if (segment.front() == '[' && segment.back() == ']' && segment.size() > 2) {
+			steps.push_back({Step::INDEX, number(segment, segment.substr(1, segment.size() - 2), 0xFFFFFFFF)});
+			continue;
+		}
+
+		steps.push_back({Step::KEY, number(segment, segment, 0xFFFF)});
+	}
+}
+
+const std::vector<BinaryTreeQuery::Step>& BinaryTreeQuery::path() const {
+	return steps;
+}
+
+template <typename R>
+std::vector<BasicBinaryTreeNode<R>> BinaryTreeQuery::find(BasicBinaryTreeNode<R> root) const {
+	BinaryTreeQueryBatch batch;
+	batch.add(*this);
+
+	return batch.run(root).front();
+}
+
+/*
+ * BinaryTreeQueryBatch
+ */
+
+size_t BinaryTreeQueryBatch::add(const BinaryTreeQuery& query) {
+	uint32_t branch = 0;
+
+	for (const BinaryTreeQuery::Step& step : query.path()) {
+		auto& children = branches[branch].children;
+
+		auto it = std::find_if(children.begin(), children.end(), [&] (uint32_t child) {
+			return branches[child].step == step;
+		});
+
+		if (it != children.end()) {
+			branch = *it;
+			continue;
+		}
+
+		children.push_back(branches.size());
+		branch = branches.size();
+		branches.push_back({step, {}, {}});
+	}
+
+	branches[branch].queries.push_back(count);
+	return count ++;
+}
+
+template <typename R>
+void BinaryTreeQueryBatch::run(uint32_t branch, BasicBinaryTreeNode<R> node, std::vector<std::vector<BasicBinaryTreeNode<R>>>& results) const {
+	for (uint32_t query : branches[branch].queries) {
+		results[query].push_back(node);
+	}
+
+	for (uint32_t child : branches[branch].children) {
+		select(branches[child].step, node, [&] (BasicBinaryTreeNode<R> value) {
+			run(child, value, results);
+		});
+	}
+}
+
+template <typename R>
+std::vector<std::vector<BasicBinaryTreeNode<R>>> BinaryTreeQueryBatch::run(BasicBinaryTreeNode<R> root) const {
+	std::vector<std::vector<BasicBinaryTreeNode<R>>> results (count);
+	run(0, root, results);
+
+	return results;
+}
+
+template std::vector<BasicBinaryTreeNode<Reader>> BinaryTreeQuery::find(BasicBinaryTreeNode<Reader> root) const;
+template std::vector<BasicBinaryTreeNode<SwappedReader>> BinaryTreeQuery::find(BasicBinaryTreeNode<SwappedReader> root) const;
+template std::vector<std::vector<BasicBinaryTreeNode<Reader>>> BinaryTreeQueryBatch::run(BasicBinaryTreeNode<Reader> root) const;
+template std::vector<std::vector<BasicBinaryTreeNode<SwappedReader>>> BinaryTreeQueryBatch::run(BasicBinaryTreeNode<SwappedReader> root) const;
@@ -0,0 +1,76 @@
+
+#pragma once
+#include <common/external.hpp>
+
+#include "nodes.hpp"
+
+/// a path into the tree compiled from text like `4/2/[3]` or `8/*`, numbers select dictionary
+/// (or map) keys, `[n]` selects array elements and `*` selects all the values of a dictionary or array
+class BinaryTreeQuery {
+
+	public:
+
+		struct Step {
+
+			enum Kind : uint8_t {
+				KEY,
+				INDEX,
+				ALL,
+			};
+
+			Kind kind;
+			uint32_t value;
+
+			bool operator==(const Step& other) const = default;
+
+		};
+
+	private:
+
+		std::vector<Step> steps;
+
+	public:
+
+		/// parses the path, throws a runtime error if it is malformed
+		BinaryTreeQuery(std::string_view path);
+
+		/// returns the compiled steps of this query
+		const std::vector<Step>& path() const;
+
+		/// returns all the nodes matched by this query, missing keys and indices simply match nothing
+		template <typename R>
+		std::vector<BasicBinaryTreeNode<R>> find(BasicBinaryTreeNode<R> root) const;
+
+};
+
+/// resolves many queries in a single traversal, queries that start
+/// with the same steps share them, so each prefix is only walked once
+class BinaryTreeQueryBatch {
+
+	private:
+
+		struct Branch {
+			BinaryTreeQuery::Step step;
+			std::vector<uint32_t> children;
+			std::vector<uint32_t> queries; // ending at this branch
+		};
+
+		// the first branch is the root, it has no step
+		std::vector<Branch> branches {1};
+		size_t count = 0;
+
+		/// matches the node against all queries passing through the branch
+		template <typename R>
+		void run(uint32_t branch, BasicBinaryTreeNode<R> node, std::vector<std::vector<BasicBinaryTreeNode<R>>>& results) const;
+
+	public:
+
+		/// adds the query to the batch, returns the index of its results
+		size_t add(const BinaryTreeQuery& query);
+
+		/// returns the matched nodes of each query, in the order they were added, this
+		/// is available for the `Reader` and `SwappedReader` based nodes
+		template <typename R>
+		std::vector<std::vector<BasicBinaryTreeNode<R>>> run(BasicBinaryTreeNode<R> root) const;
+
+};
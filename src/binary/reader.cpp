@@ -1,10 +1,23 @@
 
 #include "reader.hpp"
 
-Reader::Reader(const void* base)
-: base((uint8_t*) base), head((uint8_t*) base) {}
+Reader::Reader(const void* base, SectionSource* source, uint16_t flags)
+: base((uint8_t*) base), head((uint8_t*) base), source(source), format(flags) {}
+
+uint16_t Reader::flags() const {
+	return format;
+}
+
+void Reader::flags(uint16_t flags) {
+	this->format = flags;
+}
+
+void Reader::jump(uint32_t offset, uint8_t type) {
+	if (source) {
+		this->head = source->resolve(offset, type);
+		return;
+	}
 
-void Reader::jump(uint32_t offset) {
 	this->head = this->base + offset;
 }
 
@@ -2,21 +2,53 @@
 #pragma once
 #include <common/external.hpp>
 
+#include "swap.hpp"
+#include "types.hpp"
+
+/// maps section offsets to memory for data that isn't stored as one contiguous range, the returned pointer
+/// needs to be valid until the end of that section, `type` is the type of the node that links to the section
+/// or one of `BinarySection`, so that sources that only hold parts of the file know how much of it is needed
+class SectionSource {
+
+	public:
+
+		virtual ~SectionSource() = default;
+
+		/// returns a pointer to the byte at `offset`
+		virtual const uint8_t* resolve(uint32_t offset, uint8_t type) = 0;
+
+		/// returns the number of bytes that can be read starting at `offset`, zero if the offset is not valid
+		virtual size_t extent(uint32_t offset, uint8_t type) = 0;
+
+		/// releases the memory over the limit of the source, this invalidates the pointers returned so far
+		virtual void trim() {}
+
+};
+
 class Reader {
 
 	private:
 
 		const uint8_t* base; // start of the data region
 		const uint8_t* head; // current location
+		SectionSource* source; // used instead of `base` if set
+		uint16_t format; // header flags that affect the section layout
 
 	public:
 
 		Reader() = default;
 
-		Reader(const void* base);
+		Reader(const void* base, SectionSource* source = nullptr, uint16_t flags = 0);
 
-		/// Move to the specified offset within the data array
-		void jump(uint32_t offset);
+		/// Returns the header flags of the file this reader points into
+		uint16_t flags() const;
+
+		/// Sets the header flags, the nodes use them to pick the right section layout
+		void flags(uint16_t flags);
+
+		/// Move to the specified offset within the data array, `type` tells the
+		/// section source what is stored there, see `SectionSource::resolve()`
+		void jump(uint32_t offset, uint8_t type = BinarySection::SLOT);
 
 		/// Skip `offset` bytes forward within the data array
 		void skip(uint32_t offset);
@@ -26,12 +58,56 @@ class Reader {
 
 	public:
 
+		/// converts a value between the byte order of the data and the native one
+		template <typename T>
+		static T convert(T value) {
+			return value;
+		}
+
+		/// read the type `T` stored at the given location
+		template <typename T>
+		static T load(const void* pointer) {
+			T value;
+			memcpy(&value, pointer, sizeof(T));
+			return value;
+		}
+
 		/// read the type `T` from the underlying data array
 		template <typename T>
 		T read() {
-			T value = *reinterpret_cast<const T*>(head);
+			T value = load<T>(head);
 			head += sizeof(T);
 			return value;
 		}
 
 };
+
+/// a reader for data stored in the opposite byte order, all the values are swapped as they are read,
+/// nodes are templated on the reader type, so that native data doesn't pay for this
+class SwappedReader : public Reader {
+
+	public:
+
+		SwappedReader() = default;
+
+		explicit SwappedReader(const Reader& reader)
+		: Reader(reader) {}
+
+	public:
+
+		template <typename T>
+		static T convert(T value) {
+			return ByteSwap::value(value);
+		}
+
+		template <typename T>
+		static T load(const void* pointer) {
+			return convert(Reader::load<T>(pointer));
+		}
+
+		template <typename T>
+		T read() {
+			return convert(Reader::read<T>());
+		}
+
+};
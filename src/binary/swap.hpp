@@ -0,0 +1,103 @@
+
+#pragma once
+#include <common/external.hpp>
+
+/// converts values between little and big endian byte order
+class ByteSwap {
+
+	private:
+
+		template <typename U>
+		static inline U integer(U value) {
+			if constexpr (sizeof(U) == 1) return value;
+			if constexpr (sizeof(U) == 2) return (U) ((value << 8) | (value >> 8));
+
+#if defined(__GNUC__) || defined(__clang__)
+			if constexpr (sizeof(U) == 4) return __builtin_bswap32(value);
+			if constexpr (sizeof(U) == 8) return __builtin_bswap64(value);
+#else
+			U result = 0;
+
+			for (size_t i = 0; i < sizeof(U); i ++) {
+				result = (result << 8) | ((value >> (i * 8)) & 0xFF);
+			}
+
+			return result;
+#endif
+		}
+
+		template <typename U>
+		static void scalar(uint8_t* output, const uint8_t* input, size_t count) {
+			for (size_t i = 0; i < count; i ++) {
+				U value;
+				memcpy(&value, input + i * sizeof(U), sizeof(U));
+				value = integer(value);
+				memcpy(output + i * sizeof(U), &value, sizeof(U));
+			}
+		}
+
+#if defined(__SSE2__)
+		/// swaps the bytes of each `width` byte value in the vector
+		static inline __m128i vector(__m128i value, size_t width) {
+#if defined(__SSSE3__)
+			static const __m128i masks[3] = {
+				_mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14),
+				_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12),
+				_mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8),
+			};
+
+			return _mm_shuffle_epi8(value, masks[std::countr_zero(width) - 1]);
+#else
+			// reorder the 16 bit words first, then swap the bytes within each word
+			if (width == 4) {
+				value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			}
+
+			if (width == 8) {
+				value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+			}
+
+			return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+#endif
+		}
+#endif
+
+	public:
+
+		/// returns the value with its bytes in reverse order, floating point values are swapped as integers
+		template <typename T> requires std::is_arithmetic_v<T>
+		static inline T value(T value) {
+			using U = std::conditional_t<sizeof(T) == 1, uint8_t, std::conditional_t<sizeof(T) == 2, uint16_t, std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>>;
+			return std::bit_cast<T>(integer(std::bit_cast<U>(value)));
+		}
+
+		/// copies `count` values of `width` bytes each from `input` to `output`, swapping their bytes,
+		/// the width needs to be one, two, four or eight, the arrays don't need to be aligned
+		static void bulk(void* output, const void* input, size_t count, size_t width) {
+			uint8_t* target = static_cast<uint8_t*>(output);
+			const uint8_t* source = static_cast<const uint8_t*>(input);
+			size_t head = 0;
+
+			if (width == 1) {
+				memcpy(output, input, count);
+				return;
+			}
+
+#if defined(__SSE2__)
+			size_t bytes = count * width;
+
+			for (; head + 16 <= bytes; head += 16) {
+				__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + head));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(target + head), vector(block, width));
+			}
+#endif
+
+			// the remaining tail, or everything if there is no SIMD support
+			size_t rest = count - head / width;
+
+			if (width == 2) scalar<uint16_t>(target + head, source + head, rest);
+			if (width == 4) scalar<uint32_t>(target + head, source + head, rest);
+			if (width == 8) scalar<uint64_t>(target + head, source + head, rest);
+		}
+
+};
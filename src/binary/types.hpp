@@ -10,7 +10,8 @@ struct BinaryNode {
 		DICT   = 0xF4,
 		LIST   = 0xE4,
 		TEXT   = 0xD4,
-		BLOB   = 0xC4, // TODO
+		BLOB   = 0xC4,
+		MAP    = 0xB4, // large dictionary
 
 		// numerical
 		FLOAT  = 0x14, // float
@@ -20,7 +21,6 @@ struct BinaryNode {
 		INT    = 0x24, // int
 		LONG   = 0x28, // long
 
-	/*
 		// vectors
 		VEC2F  = 0x38, // 2x float
 		VEC3F  = 0x3C, // 3x float
@@ -32,10 +32,54 @@ struct BinaryNode {
 		VEC2B  = 0x32, // 2x byte
 		VEC3B  = 0x33, // 3x byte
 		VEC4B  = 0x54, // 4x byte
-	*/
 
 	};
 
 };
 
+/// the sections a reader can jump to that don't belong to a node of the same type,
+/// all the other sections are identified by the type of the node that links to them
+struct BinarySection {
+
+	enum : uint8_t {
+
+		SLOT   = 0x00, // a single type byte and its payload, like the root
+		VALUES = 0x01, // the values of a map, addressed by the offsets in its records
+		TABLE  = 0x02, // a version table, see `BinaryTreeVersions`
+
+	};
+
+};
+
+struct BinaryFlag {
+
+	enum : uint16_t {
+
+		// sections are grouped into LZ compressed blocks, listed
+		// in a block table that directly follows the header
+		COMPRESSED = 0x0001,
+
+		// dictionaries store their keys as a sorted column followed
+		// by a column of value offsets, instead of interleaving them
+		INDEXED_DICTS = 0x0002,
+
+		// text sections start with their length, not
+		// counting the terminator that still follows the text
+		SIZED_TEXT = 0x0004,
+
+		// the header points to a table with the roots of all the versions
+		// of the tree stored in the file, instead of the root itself
+		VERSIONED = 0x0008,
+
+		// every section is referenced by a single slot, set when the sections
+		// were not deduplicated, so values can be overwritten in place
+		UNIQUE_SECTIONS = 0x0010,
+
+	};
+
+	// all the flags this version can read
+	static constexpr uint16_t supported = COMPRESSED | INDEXED_DICTS | SIZED_TEXT | VERSIONED | UNIQUE_SECTIONS;
+
+};
+
 #define HEADER(node) static constexpr uint8_t header = node;
@@ -0,0 +1,283 @@
+
+#include "validator.hpp"
+#include "nodes.hpp"
+
+/// returns true for all the type bytes this version can read
+static bool known(uint8_t type) {
+	switch (type) {
+		case BinaryNode::DICT:
+		case BinaryNode::LIST:
+		case BinaryNode::TEXT:
+		case BinaryNode::BLOB:
+		case BinaryNode::MAP:
+		case BinaryNode::FLOAT:
+		case BinaryNode::DOUBLE:
+		case BinaryNode::BYTE:
+		case BinaryNode::SHORT:
+		case BinaryNode::INT:
+		case BinaryNode::LONG:
+		case BinaryNode::VEC2F:
+		case BinaryNode::VEC3F:
+		case BinaryNode::VEC2I:
+		case BinaryNode::VEC3I:
+		case BinaryNode::VEC2S:
+		case BinaryNode::VEC3S:
+		case BinaryNode::VEC4S:
+		case BinaryNode::VEC2B:
+		case BinaryNode::VEC3B:
+		case BinaryNode::VEC4B:
+			return true;
+	}
+
+	return false;
+}
+
+/// returns true for the types whose payload is a link to another section
+static bool compound(uint8_t type) {
+	return type == BinaryNode::DICT || type == BinaryNode::LIST || type == BinaryNode::TEXT || type == BinaryNode::BLOB || type == BinaryNode::MAP;
+}
+
+static std::runtime_error invalid(uint32_t offset, const std::string& message) {
+	return std::runtime_error {"Invalid section at offset " + std::to_string(offset) + ", " + message};
+}
+
+BinaryTreeValidator::BinaryTreeValidator(const uint8_t* data, size_t size, SectionSource* source, uint16_t flags, bool swapped)
+: data(data), size(size), source(source), flags(flags), swapped(swapped) {}
+
+bool BinaryTreeValidator::visit(uint32_t offset, uint8_t type) {
+
+	// identical sections of different types can share an offset, so each type has its own bits
+	int kind = type == BinaryNode::DICT ? 0 : type == BinaryNode::LIST ? 1 : type == BinaryNode::MAP ? 2 : 3;
+	std::vector<std::unique_ptr<uint64_t[]>>& pages = visited[kind];
+
+	size_t page = offset >> page_bits;
+	size_t bit = offset & ((1 << page_bits) - 1);
+
+	if (page >= pages.size()) {
+		pages.resize(page + 1);
+	}
+
+	if (!pages[page]) {
+		pages[page] = std::make_unique<uint64_t[]>((1 << page_bits) / 64);
+	}
+
+	uint64_t& word = pages[page][bit / 64];
+	uint64_t mask = 1ull << (bit % 64);
+
+	if (word & mask) {
+		return false;
+	}
+
+	word |= mask;
+	return true;
+}
+
+std::span<const uint8_t> BinaryTreeValidator::range(uint32_t offset, uint8_t type) {
+	if (source) {
+		size_t extent = source->extent(offset, type);
+		return {extent ? source->resolve(offset, type) : data, extent};
+	}
+
+	if (offset > size) {
+		return {data, 0};
+	}
+
+	return {data + offset, size - offset};
+}
+
+void BinaryTreeValidator::value(uint8_t type, const uint8_t* payload) {
+	if (!known(type)) {
+		throw std::runtime_error {"Unknown node type " + std::to_string(type)};
+	}
+
+	if (!compound(type)) {
+		return;
+	}
+
+	uint32_t offset = load<uint32_t>(payload);
+	checked ++;
+
+	// leaf sections can't form cycles, so the cheap ones are checked right
+	// away without the cost of tracking them, the others only once
+	if (type == BinaryNode::BLOB) {
+		return blob(offset, range(offset, type));
+	}
+
+	if (type == BinaryNode::TEXT) {
+		std::span<const uint8_t> bytes = range(offset, type);
+
+		if (flags & BinaryFlag::SIZED_TEXT) {
+			return text(offset, bytes);
+		}
+
+		if (!bytes.empty() && memchr(bytes.data(), 0, std::min<size_t>(bytes.size(), 256))) {
+			return;
+		}
+	}
+
+	if (visit(offset, type)) {
+		stack.push_back({offset, type});
+	}
+}
+
+void BinaryTreeValidator::dict(uint32_t offset, std::span<const uint8_t> bytes) {
+	if (bytes.size() < 1) {
+		throw invalid(offset, "dictionary is truncated");
+	}
+
+	size_t entries = bytes[0];
+	size_t head = 1;
+
+	// the key column is followed by the column of value offsets
+	if (flags & BinaryFlag::INDEXED_DICTS) {
+		size_t columns = 1 + entries * 4;
+
+		if (bytes.size() < columns) {
+			throw invalid(offset, "dictionary index is truncated");
+		}
+
+		for (size_t i = 0; i < entries; i ++) {
+			uint16_t key = load<uint16_t>(bytes.data() + 1 + i * 2);
+			uint16_t at = load<uint16_t>(bytes.data() + 1 + (entries + i) * 2);
+
+			if (i > 0 && key < load<uint16_t>(bytes.data() + 1 + (i - 1) * 2)) {
+				throw invalid(offset, "dictionary keys are not sorted");
+			}
+
+			if (at < columns || at >= bytes.size() || bytes.size() - at - 1 < BinaryTreeNode::sizeOf(bytes[at])) {
+				throw invalid(offset, "dictionary value " + std::to_string(i) + " is out of bounds");
+			}
+
+			value(bytes[at], bytes.data() + at + 1);
+		}
+
+		return;
+	}
+
+	for (size_t i = 0; i < entries; i ++) {
+		if (bytes.size() - head < 3) {
+			throw invalid(offset, "dictionary entry " + std::to_string(i) + " is truncated");
+		}
+
+		uint8_t type = bytes[head + 2];
+		head += 3;
+
+		if (bytes.size() - head < BinaryTreeNode::sizeOf(type)) {
+			throw invalid(offset, "dictionary entry " + std::to_string(i) + " is truncated");
+		}
+
+		value(type, bytes.data() + head);
+		head += BinaryTreeNode::sizeOf(type);
+	}
+}
+
+void BinaryTreeValidator::map(uint32_t offset, std::span<const uint8_t> bytes) {
+	if (bytes.size() < 8) {
+		throw invalid(offset, "map is truncated");
+	}
+
+	uint64_t entries = load<uint32_t>(bytes.data());
+	std::span<const uint8_t> values = range(load<uint32_t>(bytes.data() + 4), BinarySection::VALUES);
+
+	if ((bytes.size() - 8) / 6 < entries) {
+		throw invalid(offset, "map records are truncated");
+	}
+
+	const uint8_t* records = bytes.data() + 8;
+	uint16_t previous = 0;
+
+	for (uint64_t i = 0; i < entries; i ++) {
+		uint16_t key = load<uint16_t>(records + i * 6);
+		uint32_t at = load<uint32_t>(records + i * 6 + 2);
+
+		if (key < previous) {
+			throw invalid(offset, "map keys are not sorted");
+		}
+
+		if (at >= values.size() || values.size() - at - 1 < BinaryTreeNode::sizeOf(values[at])) {
+			throw invalid(offset, "map value " + std::to_string(i) + " is out of bounds");
+		}
+
+		value(values[at], values.data() + at + 1);
+		previous = key;
+	}
+}
+
+void BinaryTreeValidator::list(uint32_t offset, std::span<const uint8_t> bytes) {
+	if (bytes.size() < 5) {
+		throw invalid(offset, "array is truncated");
+	}
+
+	uint64_t entries = load<uint32_t>(bytes.data());
+	uint8_t type = bytes[4];
+	uint32_t stride = BinaryTreeNode::sizeOf(type);
+
+	if (!known(type)) {
+		throw invalid(offset, "array has an unknown element type");
+	}
+
+	if ((bytes.size() - 5) / stride < entries) {
+		throw invalid(offset, "array elements are truncated");
+	}
+
+	// primitive elements need no further checks
+	if (compound(type)) {
+		for (uint64_t i = 0; i < entries; i ++) {
+			value(type, bytes.data() + 5 + i * stride);
+		}
+	}
+}
+
+void BinaryTreeValidator::text(uint32_t offset, std::span<const uint8_t> bytes) {
+
+	// the terminator is still required after the sized text
+	if (flags & BinaryFlag::SIZED_TEXT) {
+		if (bytes.size() < 5 || bytes.size() - 5 < load<uint32_t>(bytes.data()) || bytes[4 + load<uint32_t>(bytes.data())] != 0) {
+			throw invalid(offset, "text is truncated");
+		}
+
+		return;
+	}
+
+	if (bytes.empty() || memchr(bytes.data(), 0, bytes.size()) == nullptr) {
+		throw invalid(offset, "text is not terminated");
+	}
+}
+
+void BinaryTreeValidator::blob(uint32_t offset, std::span<const uint8_t> bytes) {
+	if (bytes.size() < 4 || bytes.size() - 4 < load<uint32_t>(bytes.data())) {
+		throw invalid(offset, "blob is truncated");
+	}
+}
+
+size_t BinaryTreeValidator::validate(uint32_t root) {
+	std::span<const uint8_t> slot = range(root, BinarySection::SLOT);
+
+	if (slot.size() < 1 || slot.size() - 1 < BinaryTreeNode::sizeOf(slot[0])) {
+		throw invalid(root, "root node is truncated");
+	}
+
+	value(slot[0], slot.data() + 1);
+
+	while (!stack.empty()) {
+		Section section = stack.back();
+		std::span<const uint8_t> bytes = range(section.offset, section.type);
+		stack.pop_back();
+
+		switch (section.type) {
+			case BinaryNode::DICT: dict(section.offset, bytes); break;
+			case BinaryNode::MAP: map(section.offset, bytes); break;
+			case BinaryNode::LIST: list(section.offset, bytes); break;
+			case BinaryNode::TEXT: text(section.offset, bytes); break;
+			case BinaryNode::BLOB: blob(section.offset, bytes); break;
+		}
+
+		// nothing read so far is used past this point, the sections still
+		// on the stack are only offsets, so the cached data can be released
+		if (source) {
+			source->trim();
+		}
+	}
+
+	return checked;
+}
@@ -0,0 +1,70 @@
+
+#pragma once
+#include <common/external.hpp>
+
+#include "reader.hpp"
+
+/// checks the structure of a tree once, so that it can later be read without any bounds checks,
+/// it verifies every link, count, type byte and text terminator against the size of the data,
+/// sections are visited with an explicit stack so deeply nested trees can't exhaust the call stack
+class BinaryTreeValidator {
+
+	private:
+
+		struct Section {
+			uint32_t offset;
+			uint8_t type;
+		};
+
+		const uint8_t* data;
+		size_t size;
+		SectionSource* source;
+		uint16_t flags;
+		bool swapped;
+
+		std::vector<Section> stack;
+
+		// one bit per offset for each type of section that can be visited, so that a section shared
+		// by many parents is only checked once and cycles in the links are not followed, the bits
+		// are allocated in pages as they are first used and keep a similar order to the sections
+		static constexpr int page_bits = 16;
+		std::vector<std::unique_ptr<uint64_t[]>> visited[4];
+
+		// the number of links followed, including the ones to already visited sections
+		size_t checked = 0;
+
+		/// reads the value at the given location, converting it from the byte order of the data
+		template <typename T>
+		T load(const uint8_t* pointer) const {
+			T value = Reader::load<T>(pointer);
+			return swapped ? ByteSwap::value(value) : value;
+		}
+
+		/// adds the section to the visited set, returns false if it was already there
+		bool visit(uint32_t offset, uint8_t type);
+
+		/// returns the bytes from the offset to the end of the contiguous range containing
+		/// it, `type` is what is stored there, see `SectionSource::resolve()`
+		std::span<const uint8_t> range(uint32_t offset, uint8_t type);
+
+		/// checks the type byte and pushes the section the payload links to, if any
+		void value(uint8_t type, const uint8_t* payload);
+
+		void dict(uint32_t offset, std::span<const uint8_t> bytes);
+		void map(uint32_t offset, std::span<const uint8_t> bytes);
+		void list(uint32_t offset, std::span<const uint8_t> bytes);
+		void text(uint32_t offset, std::span<const uint8_t> bytes);
+		void blob(uint32_t offset, std::span<const uint8_t> bytes);
+
+	public:
+
+		/// prepares to check the data, for compressed and paged files the `source` has to be set, it is
+		/// trimmed after each section, so its cache stays bounded, `flags` are the header flags of the
+		/// file and `swapped` needs to be set if it was written in the opposite byte order
+		BinaryTreeValidator(const uint8_t* data, size_t size, SectionSource* source, uint16_t flags, bool swapped = false);
+
+		/// checks the node at the given offset and everything reachable from it, throws a runtime
+		/// error describing the first problem found, returns the number of checked links
+		size_t validate(uint32_t root);
+
+};
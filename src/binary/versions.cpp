@@ -0,0 +1,85 @@
+
+#include "versions.hpp"
+
+BinaryTreeVersions::BinaryTreeVersions(const uint8_t* data, size_t size, uint32_t table, bool swapped, SectionSource* source)
+: data(data), length(size), swapped(swapped), source(source), head(table) {
+
+	this->first = load(table, 0);
+	this->count = load(table, 1);
+
+	if (count > capacity || (uint64_t) first + count > 0xFFFFFFFF) {
+		throw std::runtime_error {"Version table at offset " + std::to_string(table) + " is invalid"};
+	}
+
+	// the last root has to be in the data too
+	if (count > 0) {
+		load(table, 3 + count - 1);
+	}
+}
+
+uint32_t BinaryTreeVersions::load(uint32_t table, uint32_t index) const {
+	uint64_t end = (uint64_t) index * 4 + 4;
+
+	if (source ? source->extent(table, BinarySection::TABLE) < end : table + end > length) {
+		throw std::runtime_error {"Version table at offset " + std::to_string(table) + " lies outside of the file"};
+	}
+
+	uint32_t value;
+	memcpy(&value, (source ? source->resolve(table, BinarySection::TABLE) : data + table) + index * 4, 4);
+
+	return swapped ? ByteSwap::value(value) : value;
+}
+
+std::vector<uint8_t> BinaryTreeVersions::empty() {
+	return std::vector<uint8_t> (12, 0);
+}
+
+uint32_t BinaryTreeVersions::size() const {
+	return first + count;
+}
+
+uint32_t BinaryTreeVersions::root(uint32_t version) const {
+	if (version >= size()) {
+		throw std::runtime_error {"Version " + std::to_string(version) + " doesn't exist, the file has " + std::to_string(size()) + " versions"};
+	}
+
+	uint32_t table = head;
+	uint32_t start = first;
+
+	// older versions are found by following the links to the previous tables
+	while (version < start) {
+		uint32_t previous = load(table, 2);
+
+		// each table needs to end right where the newer one starts, so the walk always makes progress
+		if (previous == 0 || load(previous, 1) == 0 || load(previous, 1) > capacity || load(previous, 0) + load(previous, 1) != start) {
+			throw std::runtime_error {"Version table at offset " + std::to_string(previous) + " is invalid"};
+		}
+
+		table = previous;
+		start -= load(previous, 1);
+	}
+
+	return load(table, 3 + version - start);
+}
+
+std::vector<uint8_t> BinaryTreeVersions::next(uint32_t root) const {
+	std::vector<uint32_t> words;
+
+	// a full table is kept and linked from the new one
+	if (count == capacity) {
+		words = {size(), 1, head, root};
+	} else {
+		words = {first, count + 1, load(head, 2)};
+
+		for (uint32_t i = 0; i < count; i ++) {
+			words.push_back(load(head, 3 + i));
+		}
+
+		words.push_back(root);
+	}
+
+	std::vector<uint8_t> table (words.size() * 4);
+	memcpy(table.data(), words.data(), table.size());
+
+	return table;
+}
@@ -0,0 +1,51 @@
+
+#pragma once
+#include <common/external.hpp>
+
+#include "reader.hpp"
+
+/// the table of versions in a file with the `VERSIONED` flag, the header points to the newest table section,
+/// laid out as [u32 first version][u32 count][u32 previous table][u32 roots...], each section holds the
+/// roots of up to `capacity` consecutive versions and links to the section with the versions before them
+class BinaryTreeVersions {
+
+	private:
+
+		const uint8_t* data;
+		size_t length;
+		bool swapped;
+
+		// used instead of `data` if set
+		SectionSource* source;
+
+		uint32_t head;
+		uint32_t first;
+		uint32_t count;
+
+		/// reads the value at the given index of the table section, throws if it doesn't fit in the data
+		uint32_t load(uint32_t table, uint32_t index) const;
+
+	public:
+
+		static constexpr uint32_t capacity = 64;
+
+		/// reads the newest table section at the given offset, the older sections are only read when needed,
+		/// files that are not stored as one contiguous range are read through the `source` instead
+		BinaryTreeVersions(const uint8_t* data, size_t size, uint32_t table, bool swapped = false, SectionSource* source = nullptr);
+
+		/// returns the table section of a file that has no versions yet
+		static std::vector<uint8_t> empty();
+
+	public:
+
+		/// returns the number of versions in the file
+		uint32_t size() const;
+
+		/// returns the offset of the root of the given version, the first version has index zero
+		uint32_t root(uint32_t version) const;
+
+		/// returns the table section that adds a version with the given root to this table, it needs to be
+		/// placed at an offset that is a multiple of four, the older sections stay in use, so they are not copied
+		std::vector<uint8_t> next(uint32_t root) const;
+
+};
@@ -1,6 +1,36 @@
 
 #include "writer.hpp"
 #include "header.hpp"
+#include "hash.hpp"
+#include "blocks.hpp"
+#include "codec.hpp"
+
+/// calls `function(begin, end)` over consecutive chunks of the [0, count) range, each
+/// chunk on a separate thread, small ranges are processed on the calling thread
+template <typename F>
+static void parallel(size_t count, unsigned threads, F function) {
+
+	if (threads == 0) {
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	// don't bother starting threads for less than a few thousand sections each
+	threads = std::min<size_t>(threads, std::max<size_t>(count / 4096, 1));
+
+	if (threads <= 1) {
+		function(0, count);
+		return;
+	}
+
+	std::vector<std::jthread> workers;
+	size_t step = (count + threads - 1) / threads;
+
+	for (size_t begin = step; begin < count; begin += step) {
+		workers.emplace_back(function, begin, std::min(begin + step, count));
+	}
+
+	function(0, step);
+}
 
 /*
  * SectionBuffer
@@ -9,59 +39,205 @@
 SectionBuffer::Link::Link(SectionBuffer* buffer, uint32_t offset)
 : buffer(buffer), offset(offset) {}
 
-void SectionBuffer::finalize(int bytes) {
-	this->hashed = std::hash<std::string_view>()(std::string_view {(char*) data.data(), (size_t) std::min(bytes, (int) data.size())});
+SectionBuffer::SectionBuffer(SectionArena* arena)
+: arena(arena) {}
+
+void SectionBuffer::reserve(size_t size) {
+	if (length + size <= capacity) {
+		return;
+	}
+
+	// closed sections have no capacity left, so this is only checked on the slow path
+	if (closed) {
+		throw std::runtime_error {"Unable to modify the section, it was already closed"};
+	}
+
+	// grow in powers of two, the old block is returned to the arena
+	uint32_t target = std::bit_ceil(std::max<uint32_t>(length + size, 16));
+	uint8_t* block = static_cast<uint8_t*>(arena->block(target));
+
+	if (length) {
+		memcpy(block, data, length);
+	}
+
+	arena->release(data, capacity);
+	this->data = block;
+	this->capacity = target;
+}
+
+void SectionBuffer::release() {
+	arena->release(data, capacity);
+	arena->release(links, link_capacity * sizeof(Link));
+
+	this->data = nullptr;
+	this->links = nullptr;
+	this->length = this->capacity = 0;
+	this->link_count = this->link_capacity = 0;
+}
+
+void SectionBuffer::finalize() {
+
+	// the records are unpacked so that they can be sorted
+	// without worrying about the alignment of the data
+	if (indexed) {
+		thread_local std::vector<std::pair<uint16_t, uint32_t>> records;
+		records.resize((length - indexed) / 6);
+
+		for (size_t i = 0; i < records.size(); i ++) {
+			memcpy(&records[i].first, data + indexed + i * 6, 2);
+			memcpy(&records[i].second, data + indexed + i * 6 + 2, 4);
+		}
+
+		std::sort(records.begin(), records.end());
+
+		for (size_t i = 0; i < records.size(); i ++) {
+			memcpy(data + indexed + i * 6, &records[i].first, 2);
+			memcpy(data + indexed + i * 6 + 2, &records[i].second, 4);
+		}
+	}
+
+	// clear the offsets patched by a previous emit, so that
+	// the data only differs if the unlinked bytes differ
+	for (const Link& link : std::span {links, link_count}) {
+		if (link.buffer) {
+			memset(data + link.offset, 0, 4);
+		}
+	}
+
+	this->hashed = SectionHash::of(data, length);
 }
 
-bool SectionBuffer::equal(std::vector<uint8_t>& output, uint32_t offset) {
-	return memcmp(output.data() + offset, data.data(), data.size()) == 0;
+void SectionBuffer::identify() {
+
+	// links that are not yet resolved are identified by the hash of the linked section
+	for (const Link& link : std::span {links, link_count}) {
+		if (link.buffer) {
+			this->hashed = SectionHash::combine(hashed, link.buffer->hashed ^ link.offset);
+		}
+	}
+}
+
+bool SectionBuffer::equal(const SectionBuffer* other) const {
+	if (length != other->length || link_count != other->link_count) {
+		return false;
+	}
+
+	// a less aligned section can't stand in for this one
+	if (alignment != other->alignment || bias != other->bias) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < link_count; i ++) {
+		const Link& self = links[i];
+		const Link& that = other->links[i];
+
+		if (self.offset != that.offset) {
+			return false;
+		}
+
+		if (self.buffer && self.buffer->canonical != that.buffer->canonical) {
+			return false;
+		}
+	}
+
+	return memcmp(data, other->data, length) == 0;
+}
+
+uint32_t SectionBuffer::aligned(uint32_t offset) const {
+	return ((offset + bias + alignment - 1) & ~(alignment - 1)) - bias;
 }
 
 size_t SectionBuffer::size() const {
-	return data.size();
+	return length;
 }
 
 size_t SectionBuffer::hash() const {
 	return hashed;
 }
 
+void SectionBuffer::align(uint32_t alignment, uint32_t bias) {
+	if (!std::has_single_bit(alignment) || alignment > 64) {
+		throw std::runtime_error {"Invalid section alignment " + std::to_string(alignment) + ", expected a power of two not larger than 64"};
+	}
+
+	this->alignment = alignment;
+	this->bias = bias % alignment;
+}
+
+void SectionBuffer::index(uint32_t start) {
+	this->indexed = start;
+}
+
 void SectionBuffer::pop() {
-	if (!data.empty()) {
-		data.pop_back();
+	if (length > 0) {
+		length --;
 	}
 }
 
 void SectionBuffer::link(SectionBuffer* other) {
-	links.emplace_back(other, data.size());
+	if (link_count == link_capacity) {
+		if (closed) {
+			throw std::runtime_error {"Unable to modify the section, it was already closed"};
+		}
+
+		uint32_t target = std::max<uint32_t>(link_capacity * 2, 4);
+		Link* block = static_cast<Link*>(arena->block(target * sizeof(Link)));
+
+		if (link_count) {
+			memcpy((void*) block, links, link_count * sizeof(Link));
+		}
+
+		arena->release(links, link_capacity * sizeof(Link));
+		this->links = block;
+		this->link_capacity = target;
+	}
+
+	other->parent = this;
+	other->slot = link_count;
+
+	new (links + link_count ++) Link {other, length};
 	write<uint32_t>(0);
 }
 
 void SectionBuffer::write(const void* bytes, size_t size) {
-	data.insert(data.end(), (const uint8_t*) bytes, ((const uint8_t*) bytes) + size);
+	reserve(size);
+	memcpy(data + length, bytes, size);
+	length += size;
+}
+
+uint8_t* SectionBuffer::extend(size_t size) {
+	reserve(size);
+	uint8_t* head = data + length;
+	length += size;
+	return head;
 }
 
 void SectionBuffer::set(uint32_t offset, const void* bytes, size_t size) {
-	int source = 0;
+	if (offset < length) {
+		memcpy(data + offset, bytes, std::min<size_t>(size, length - offset));
+	}
+}
 
-	while (offset < data.size() && source < size) {
-		data[offset] = ((const uint8_t*) bytes)[source];
+void SectionBuffer::insert(uint32_t offset, const void* bytes, size_t size) {
+	reserve(size);
+	memmove(data + offset + size, data + offset, length - offset);
+	memcpy(data + offset, bytes, size);
+	length += size;
 
-		source ++;
-		offset ++;
+	for (Link& link : std::span {links, link_count}) {
+		if (link.offset >= offset) {
+			link.offset += size;
+		}
 	}
 }
 
-void SectionBuffer::emit(std::vector<uint8_t>& output) {
-	this->offset = output.size();
-	output.insert(output.end(), data.begin(), data.end());
+std::span<const uint8_t> SectionBuffer::bytes() const {
+	return {data, length};
 }
 
-void SectionBuffer::link(std::vector<uint8_t>& output) {
-	uint8_t* self = output.data() + offset;
-
-	for (Link link : links) {
-		uint8_t* segment = self + link.offset;
-		memcpy(segment, &link.buffer->offset, 4);
+void SectionBuffer::patch() {
+	for (const Link& link : std::span {links, link_count}) {
+		memcpy(data + link.offset, &link.buffer->offset, 4);
 	}
 }
 
@@ -70,95 +246,675 @@ void SectionBuffer::link(std::vector<uint8_t>& output) {
  */
 
 SectionCache::SectionInfo::SectionInfo(SectionBuffer* buffer)
-: length(buffer->size()), offset(buffer->offset), hashed(buffer->hash()) {}
+: hashed(buffer->hash()), length(buffer->size()), offset(buffer->offset), buffer(buffer) {}
+
+SectionCache::SectionCache(SectionStream* stream)
+: enabled(false), stream(stream) {}
 
-SectionCache::SectionCache(bool enabled) {
+void SectionCache::prepare(const WriteConfig& config, size_t expected) {
+	this->enabled = config.section_deduplication;
+	this->limit = std::bit_floor(std::max<size_t>(config.cache_budget / sizeof(SectionInfo), 1));
+	this->count = 0;
+	this->stats = {};
 
-	// make sure initialy all lookups will miss initialy
-	// by making the full hash differ from the bucked offset
-	for (int i = 0; i <= 0xFF; i ++) {
-		bucket[i].hashed = ~i;
+	if (!enabled) {
+		return;
 	}
 
-	this->enabled = enabled;
+	// keep the table at most half full for the expected number of sections,
+	// an already big enough table is only cleared so that it can be reused
+	size_t capacity = std::min(std::bit_ceil(std::max<size_t>(expected * 2, 1024)), limit);
+
+	if (table.size() >= capacity && table.size() <= limit) {
+		capacity = table.size();
+	}
+
+	if (capacity > table.capacity()) {
+		stats.allocations ++;
+	}
+
+	table.assign(capacity, SectionInfo {});
+}
+
+void SectionCache::grow() {
+	std::vector<SectionInfo> previous (table.size() * 2);
+	std::swap(previous, table);
+	stats.allocations ++;
+
+	size_t mask = table.size() - 1;
+
+	for (const SectionInfo& info : previous) {
+		if (info.length == 0) {
+			continue;
+		}
+
+		size_t index = info.hashed & mask;
+
+		while (table[index].length != 0) {
+			index = (index + 1) & mask;
+		}
+
+		table[index] = info;
+	}
 }
 
-void SectionCache::emit(SectionBuffer* buffer, std::vector<uint8_t>& output) {
+std::pair<SectionCache::SectionInfo*, bool> SectionCache::lookup(SectionBuffer* buffer) {
 	uint64_t hash = buffer->hash();
 
-	// don't cache sections with links
-	// links can differ or otherwise identical data
-	if (enabled && buffer->links.empty()) {
-		SectionInfo& info = bucket[hash & 0xFF];
+	if (!enabled || buffer->size() == 0) {
+		return {nullptr, false};
+	}
+
+	// grow at 75% load, as long as the memory budget allows it
+	if ((count + 1) * 4 > table.size() * 3 && table.size() * 2 <= limit) {
+		grow();
+	}
+
+	size_t mask = table.size() - 1;
+	size_t home = hash & mask;
+
+	for (size_t probe = 0; ; probe ++) {
+		SectionInfo& info = table[(home + probe) & mask];
+
+		// not in the table, we can insert it here
+		if (info.length == 0) {
+			count ++;
+			return {&info, false};
+		}
 
 		// verify if the full hash and length match
 		if (info.hashed == hash && info.length == buffer->size()) {
 
-			// actually comapre the data in the sections
-			if (buffer->equal(output, info.offset)) {
-				buffer->offset = info.offset;
-
+			// actually comapre the data in the sections, when streaming the already written
+			// section also needs to be placed at an offset suitable for this one
+			if (stream ? buffer->aligned(info.offset) == info.offset && stream->equal(info.offset, buffer->bytes()) : buffer->equal(info.buffer)) {
 				stats.cache_hits ++;
 				stats.total_skipped += info.length;
-				return;
+				return {&info, true};
 			} else {
 				stats.cache_fails ++;
 			}
 		}
+
+		// the table is over-full, replace the home entry
+		if (probe == max_probes) {
+			stats.cache_evictions ++;
+			return {&table[home], false};
+		}
+
+		stats.cache_probes ++;
+	}
+}
+
+void SectionCache::place(SectionBuffer* buffer, uint32_t& end) {
+	auto [slot, found] = lookup(buffer);
+
+	if (found) {
+		buffer->offset = slot->offset;
+		return;
 	}
 
 	// cache miss, write the buffer and add to cache
 	stats.cache_misses ++;
-	buffer->emit(output);
-	bucket[hash & 0xFF] = {buffer};
+	buffer->offset = buffer->aligned(end);
+	buffer->padding = buffer->offset - end;
+	buffer->written = true;
+
+	// the buffer will be released after being streamed
+	if (slot) {
+		*slot = {buffer};
+		slot->buffer = nullptr;
+	}
+
+	end = buffer->offset + buffer->size();
+}
+
+void SectionCache::resolve(SectionBuffer* buffer) {
+	auto [slot, found] = lookup(buffer);
+
+	if (found) {
+		buffer->canonical = slot->buffer;
+		return;
+	}
+
+	stats.cache_misses ++;
+	buffer->canonical = buffer;
+
+	if (slot) {
+		*slot = {buffer};
+	}
 }
 
 WriteResult SectionCache::result() const {
 	return this->stats;
 }
 
+/*
+ * SectionStream
+ */
+
+SectionStream::SectionStream(OutputFile& output, uint32_t base, const WriteConfig& config)
+: output(output), cache(this), flushed(base) {
+	cache.prepare(config, 0);
+	pending.reserve(batch_size);
+}
+
+void SectionStream::place(SectionBuffer* buffer) {
+	uint32_t end = flushed + pending.size();
+	cache.place(buffer, end);
+
+	if (buffer->written) {
+		std::span<const uint8_t> bytes = buffer->bytes();
+		pending.resize(pending.size() + buffer->padding);
+		pending.insert(pending.end(), bytes.begin(), bytes.end());
+
+		if (pending.size() >= batch_size) {
+			flush();
+		}
+	}
+}
+
+bool SectionStream::equal(uint32_t offset, std::span<const uint8_t> bytes) {
+
+	// the section is still staged
+	if (offset >= flushed) {
+		return memcmp(pending.data() + (offset - flushed), bytes.data(), bytes.size()) == 0;
+	}
+
+	// read back the part that was already written
+	size_t written = std::min<size_t>(flushed - offset, bytes.size());
+	scratch.resize(written);
+	output.read(offset, scratch.data(), written);
+
+	if (memcmp(scratch.data(), bytes.data(), written) != 0) {
+		return false;
+	}
+
+	return memcmp(pending.data(), bytes.data() + written, bytes.size() - written) == 0;
+}
+
+uint32_t SectionStream::size() const {
+	return flushed + pending.size();
+}
+
+void SectionStream::flush() {
+	output.write(pending.data(), pending.size());
+	flushed += pending.size();
+	pending.clear();
+}
+
+WriteResult SectionStream::result() const {
+	return cache.result();
+}
+
 /*
  * SectionManager
  */
 
-SectionManager::~SectionManager() {
-	for (SectionBuffer* buffer : buffers) {
-		delete buffer;
+SectionManager::SectionManager(const WriteConfig& config)
+: config(config) {}
+
+SectionManager::SectionManager(OutputFile& output, const WriteConfig& config)
+: output(&output), config(config) {
+	uint32_t base = 0;
+
+	// the root offset is not yet known, it will be patched by `finish()`
+	if (config.include_header) {
+		BinaryTreeHeader header {headerFlags(config), 0x00};
+		uint8_t bytes[BinaryTreeHeader::size];
+
+		header.emit(bytes);
+		output.write(bytes, BinaryTreeHeader::size);
+		base = BinaryTreeHeader::size;
+	}
+
+	if (config.compression) {
+		throw std::runtime_error {"Unable to stream, compression is not supported in streaming mode"};
 	}
+
+	this->stream = std::make_unique<SectionStream>(output, base, config);
+}
+
+uint32_t SectionManager::flush(SectionBuffer* buffer) {
+
+	// each written child back-patches its link in this buffer
+	for (const SectionBuffer::Link& link : std::span {buffer->links, buffer->link_count}) {
+		if (link.buffer) {
+			flush(link.buffer);
+		}
+	}
+
+	buffer->finalize();
+	stream->place(buffer);
+
+	if (SectionBuffer* parent = buffer->parent) {
+		SectionBuffer::Link& link = parent->links[buffer->slot];
+		memcpy(parent->data + link.offset, &buffer->offset, 4);
+		link.buffer = nullptr;
+	}
+
+	uint32_t offset = buffer->offset;
+
+	buffer->release();
+	buffer->closed = true;
+	recycled.push_back(buffer);
+
+	return offset;
 }
 
 SectionBuffer* SectionManager::allocate() {
-	SectionBuffer* buffer = new SectionBuffer;
+
+	// in streaming mode buffers are recycled after being written
+	if (stream) {
+		void* memory;
+
+		if (recycled.empty()) {
+			memory = arena.block(sizeof(SectionBuffer));
+		} else {
+			memory = recycled.front();
+			recycled.pop_front();
+		}
+
+		SectionBuffer* buffer = new (memory) SectionBuffer {&arena};
+
+		if (root == nullptr) {
+			root = buffer;
+		}
+
+		return buffer;
+	}
+
+	SectionBuffer* buffer = arena.create<SectionBuffer>(&arena);
+
+	if (buffers.size() == buffers.capacity()) {
+		allocations ++;
+	}
+
 	buffers.push_back(buffer);
 	return buffer;
 }
 
-WriteResult SectionManager::emit(std::vector<uint8_t>& output, const WriteConfig& config) {
+uint16_t SectionManager::flags() const {
+	uint16_t flags = 0;
+
+	if (config.indexed_dicts) {
+		flags |= BinaryFlag::INDEXED_DICTS;
+	}
+
+	if (config.sized_text) {
+		flags |= BinaryFlag::SIZED_TEXT;
+	}
+
+	return flags;
+}
+
+uint16_t SectionManager::headerFlags(const WriteConfig& config) const {
+	uint16_t flags = this->flags();
+
+	if (!config.section_deduplication) {
+		flags |= BinaryFlag::UNIQUE_SECTIONS;
+	}
+
+	return flags;
+}
+
+uint32_t SectionManager::alignment(uint32_t size) const {
+	if (config.array_alignment == 0) {
+		return 1;
+	}
+
+	// elements that aren't a power of two in size are aligned like the next larger one
+	return std::max<uint32_t>(config.array_alignment, std::min<uint32_t>(std::bit_ceil(size), 64));
+}
+
+void SectionManager::close(SectionBuffer* buffer) {
+	if (buffer->closed) {
+		throw std::runtime_error {"Unable to close, the section was already closed"};
+	}
+
+	if (stream && buffer != root) {
+		flush(buffer);
+	}
+}
+
+WriteResult SectionManager::finish() {
+	if (!stream) {
+		throw std::runtime_error {"Unable to finish, the section manager is not in streaming mode"};
+	}
+
+	uint32_t offset = 0;
+
+	if (root) {
+		offset = flush(root);
+		root = nullptr;
+	}
+
+	stream->flush();
 
-	size_t total = 0;
+	WriteResult result = stream->result();
+	result.size = stream->size();
+	result.allocations += allocations + arena.count();
 
 	if (config.include_header) {
-		BinaryTreeHeader header {0x00, 0x0C};
-		header.emit(output);
+		BinaryTreeHeader header {headerFlags(config), offset};
+		uint8_t bytes[BinaryTreeHeader::size];
 
-		total += BinaryTreeHeader::size;
+		header.emit(bytes);
+		output->patch(0, bytes, BinaryTreeHeader::size);
 	}
 
+	return result;
+}
+
+uint32_t SectionManager::layout(uint32_t base, const WriteConfig& config, WriteResult& result) {
+
+	if (stream) {
+		throw std::runtime_error {"Unable to emit, the section manager is in streaming mode, use finish()"};
+	}
+
+	cache.prepare(config, buffers.size());
+	uint32_t end = base;
+
+	// hashing the data is the expensive part, it only touches the section itself
+	parallel(buffers.size(), config.threads, [&] (size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i ++) {
+			buffers[i]->finalize();
+			buffers[i]->offset = unplaced;
+			buffers[i]->written = false;
+		}
+	});
+
+	// children are always allocated after their parents, so going backwards
+	// every section is resolved before any of the sections that link to it
+	for (SectionBuffer* buffer : buffers | std::views::reverse) {
+		buffer->identify();
+		cache.resolve(buffer);
+	}
+
+	// identical sections share the offset of the first one in the group
 	for (SectionBuffer* buffer : buffers) {
-		total += buffer->size();
-		buffer->finalize(config.hash_bytes);
+		SectionBuffer* group = buffer->canonical;
+
+		// all sections in a group have the same alignment
+		if (group->offset == unplaced) {
+			group->offset = buffer->aligned(end);
+			buffer->padding = group->offset - end;
+			buffer->written = true;
+			end = group->offset + buffer->size();
+		}
+
+		buffer->offset = group->offset;
 	}
 
-	output.reserve(total);
-	SectionCache cache {config.section_deduplication};
+	parallel(buffers.size(), config.threads, [&] (size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i ++) {
+			buffers[i]->patch();
+		}
+	});
+
+	result = cache.result();
+	result.allocations += allocations + arena.count();
+
+	return end;
+}
+
+void SectionManager::copy(uint8_t* output, size_t start, uint32_t base, const WriteConfig& config, uint32_t origin) {
+
+	if (config.include_header) {
+		BinaryTreeHeader header {headerFlags(config), buffers.empty() ? base : buffers.front()->offset};
+		header.emit(output + start);
+	}
+
+	// every written section has its final offset, so they can be copied in any order
+	parallel(buffers.size(), config.threads, [&] (size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i ++) {
+			SectionBuffer* buffer = buffers[i];
+
+			if (buffer->written) {
+				memset(output + buffer->offset - origin - buffer->padding, 0, buffer->padding);
+				memcpy(output + buffer->offset - origin, buffer->data, buffer->length);
+			}
+		}
+	});
+}
+
+template <typename F>
+size_t SectionManager::compress(size_t start, uint32_t base, const WriteConfig& config, F write) {
+
+	if (!config.include_header) {
+		throw std::runtime_error {"Unable to compress, compressed output needs the header"};
+	}
+
+	// sections are never split between blocks, so that each section can be read from a single
+	// decompressed block, the blocks are planned first so that the size of the table is known
+	entries.clear();
 
 	for (SectionBuffer* buffer : buffers) {
-		cache.emit(buffer, output);
+		if (!buffer->written) {
+			continue;
+		}
+
+		uint32_t end = buffer->offset + buffer->length;
+
+		if (entries.empty() || (entries.back().length != 0 && end - entries.back().start > config.block_size)) {
+			entries.push_back({buffer->offset, 0, 0, 0});
+		}
+
+		// a block that holds no bytes yet starts at the next section instead
+		if (entries.back().length == 0) {
+			entries.back().start = buffer->offset;
+		}
+
+		entries.back().length = end - entries.back().start;
+	}
+
+	if (!entries.empty() && entries.back().length == 0) {
+		entries.pop_back();
+	}
+
+	// the block table directly follows the header, it is written with placeholder
+	// offsets first, so that the compressed blocks can be written right after it
+	uint32_t count = entries.size();
+	size_t table = start + BinaryTreeHeader::size + 4;
+	size_t position = table + count * BlockEntry::size;
+
+	uint8_t bytes[BinaryTreeHeader::size + 4];
+	BinaryTreeHeader header {(uint16_t) (headerFlags(config) | BinaryFlag::COMPRESSED), buffers.empty() ? base : buffers.front()->offset};
+	header.emit(bytes);
+	memcpy(bytes + BinaryTreeHeader::size, &count, 4);
+
+	write(start, bytes, sizeof(bytes));
+	write(table, entries.data(), count * BlockEntry::size);
+
+	size_t next = 0;
+
+	for (BlockEntry& entry : entries) {
+		uint32_t filled = entry.start;
+		plain.resize(entry.length);
+
+		// copy the sections of this block, zeroing the padding between them
+		for (; next < buffers.size(); next ++) {
+			SectionBuffer* buffer = buffers[next];
+
+			if (!buffer->written || buffer->length == 0) {
+				continue;
+			}
+
+			if (buffer->offset >= entry.start + entry.length) {
+				break;
+			}
+
+			memset(plain.data() + filled - entry.start, 0, buffer->offset - filled);
+			memcpy(plain.data() + buffer->offset - entry.start, buffer->data, buffer->length);
+			filled = buffer->offset + buffer->length;
+		}
+
+		packed.clear();
+		BlockCodec::compress(plain.data(), plain.size(), packed);
+
+		entry.offset = position;
+		entry.packed = packed.size();
+
+		write(position, packed.data(), packed.size());
+		position += packed.size();
+	}
+
+	write(table, entries.data(), count * BlockEntry::size);
+	return position - start;
+}
+
+void SectionManager::reset() {
+	if (stream) {
+		throw std::runtime_error {"Unable to reset, the section manager is in streaming mode"};
+	}
+
+	buffers.clear();
+	arena.clear();
+	allocations = 0;
+}
+
+WriteResult SectionManager::emit(std::vector<uint8_t>& output, const WriteConfig& config) {
+
+	WriteResult result;
+	size_t start = output.size();
+	size_t base = start + (config.include_header ? BinaryTreeHeader::size : 0);
+	size_t end = layout(base, config, result);
+
+	if (config.compression) {
+		result.size = compress(start, base, config, [&] (size_t offset, const void* data, size_t size) {
+			if (offset + size > output.size()) {
+				output.resize(offset + size);
+			}
+
+			memcpy(output.data() + offset, data, size);
+		});
+
+		return result;
+	}
+
+	if (end > output.capacity()) {
+		result.allocations ++;
+	}
+
+	output.resize(end);
+	copy(output.data(), start, base, config);
+
+	result.size = end - start;
+	return result;
+}
+
+WriteResult SectionManager::emit(std::vector<uint8_t>& output, uint32_t base, const WriteConfig& config) {
+
+	if (config.compression) {
+		throw std::runtime_error {"Unable to compress, sections appended to a file can't be compressed"};
+	}
+
+	WriteConfig headless = config;
+	headless.include_header = false;
+
+	WriteResult result;
+	size_t start = output.size();
+	uint32_t end = layout(base, headless, result);
+
+	output.resize(start + end - base);
+	copy(output.data() + start, 0, base, headless, base);
+
+	result.size = end - base;
+	return result;
+}
+
+WriteResult SectionManager::emit(std::span<uint8_t> output, const WriteConfig& config) {
+
+	WriteResult result;
+	uint32_t base = config.include_header ? BinaryTreeHeader::size : 0;
+	uint32_t end = layout(base, config, result);
+
+	result.size = end;
+
+	// the compressed size is only known after compressing, so the blocks that still
+	// fit are written and the rest is only measured, to report the required size
+	if (config.compression) {
+		result.size = compress(0, base, config, [&] (size_t offset, const void* data, size_t size) {
+			if (offset + size > output.size()) {
+				result.overflow = true;
+				return;
+			}
+
+			memcpy(output.data() + offset, data, size);
+		});
+
+		return result;
+	}
+
+	if (end > output.size()) {
+		result.overflow = true;
+		return result;
+	}
+
+	copy(output.data(), 0, base, config);
+	return result;
+}
+
+WriteResult SectionManager::emit(OutputFile& output, const WriteConfig& config) {
+
+	WriteResult result;
+	uint32_t base = config.include_header ? BinaryTreeHeader::size : 0;
+	result.size = layout(base, config, result);
+
+	// the blocks are appended one at a time, only the block table is patched afterwards
+	if (config.compression) {
+		size_t written = 0;
+
+		result.size = compress(0, base, config, [&] (size_t offset, const void* data, size_t size) {
+			if (offset < written) {
+				output.patch(offset, data, size);
+				return;
+			}
+
+			output.write(data, size);
+			written += size;
+		});
+
+		return result;
+	}
+
+	// the header is always the first slice in the first batch
+	static constexpr uint8_t zeros[64] = {};
+	uint8_t bytes[BinaryTreeHeader::size];
+	OutputFile::Slice batch[256];
+	size_t count = 0;
+
+	if (config.include_header) {
+		BinaryTreeHeader header {headerFlags(config), buffers.empty() ? base : buffers.front()->offset};
+		header.emit(bytes);
+
+		batch[count ++] = {bytes, BinaryTreeHeader::size};
 	}
 
 	for (SectionBuffer* buffer : buffers) {
-		buffer->link(output);
+		if (buffer->written) {
+			if (buffer->padding) {
+				batch[count ++] = {zeros, buffer->padding};
+			}
+
+			batch[count ++] = buffer->bytes();
+		}
+
+		// leave space for the padding and data slices of the next section
+		if (count >= std::size(batch) - 1) {
+			output.write(std::span {batch, count});
+			count = 0;
+		}
 	}
 
-	return cache.result();
+	output.write(std::span {batch, count});
+	return result;
+}
+
+WriteResult SectionManager::emit(const std::string& path, const WriteConfig& config) {
+	OutputFile output {path};
+	WriteResult result = emit(output, config);
+
+	output.commit();
+	return result;
 }
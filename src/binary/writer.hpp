@@ -1,21 +1,44 @@
 
 #pragma once
 #include <common/external.hpp>
+#include <common/file.hpp>
+
+#include "arena.hpp"
+#include "blocks.hpp"
 
 struct WriteResult {
 
 	// the number of bytes skipped due to caching
 	int total_skipped = 0;
 
-	// the number of expensive near-misses in the cache
+	// the number of expensive near-misses in the cache,
+	// where both the full hash and length matched but the data differed
 	int cache_fails = 0;
 
+	// the number of extra slots visited while probing the cache table
+	int cache_probes = 0;
+
+	// the number of cached sections replaced after the table hit its memory budget
+	int cache_evictions = 0;
+
 	// the number of sections skipped due to the caching
 	int cache_hits = 0;
 
 	// the number of sections not found in cache and written
 	int cache_misses = 0;
 
+	// the number of heap allocations made by the section store
+	// since it was created or last reset, including this emit
+	int allocations = 0;
+
+	// the number of bytes in the output, including the header
+	size_t size = 0;
+
+	// set when the output didn't fit into the given fixed buffer, in that case `size` holds
+	// the required size and nothing was written, except for compressed output, where the
+	// compressed size is only known at the end, so the buffer holds a partial file
+	bool overflow = false;
+
 };
 
 struct WriteConfig {
@@ -25,13 +48,46 @@ struct WriteConfig {
 	bool include_header = true;
 
 	// controls whether to try and eliminate
-	// duplicated sections, needs the hash_bytes to also be set
+	// duplicated sections
 	bool section_deduplication = true;
 
-	// controls the number of bytes to include in
-	// the section's hash value
+	// deprecated and ignored, sections are now always hashed in full, kept
+	// for one more release so that code that sets it still compiles
 	uint32_t hash_bytes = 20;
 
+	// the maximum number of bytes the deduplication table can use,
+	// once reached old entries start being replaced by new ones
+	size_t cache_budget = 64 * 1024 * 1024;
+
+	// controls whether to group the sections into LZ compressed blocks,
+	// that are decompressed by the reader on first access
+	bool compression = false;
+
+	// the maximum uncompressed size of a single block, sections
+	// larger than that are placed in a block of their own
+	uint32_t block_size = 64 * 1024;
+
+	// the number of threads used for hashing, linking and copying
+	// the sections, zero uses all available cores, the output
+	// doesn't depend on this setting
+	unsigned threads = 1;
+
+	// the options below change how the sections are built, so they are only taken
+	// from the config passed to the SectionManager constructor, not from `emit()`
+
+	// controls whether dictionaries keep their keys in a sorted column,
+	// so that lookups don't need to walk all the entries
+	bool indexed_dicts = false;
+
+	// controls whether texts are prefixed with their length, so that
+	// readers don't need to search for the end and they can contain zeros
+	bool sized_text = false;
+
+	// when set, the elements of primitive arrays start at a multiple of their size, or of
+	// this value if it is larger, so that they can be used in place with `span()`, needs
+	// to be a power of two not larger than 64, use 64 to align them to a cache line
+	uint32_t array_alignment = 0;
+
 };
 
 class SectionBuffer {
@@ -51,19 +107,74 @@ class SectionBuffer {
 		uint32_t offset = 0;
 		uint64_t hashed = 0;
 
-		std::vector<uint8_t> data;
-		std::vector<Link> links;
+		// set if the section was not mapped to an identical
+		// section and needs to be written into the output
+		bool written = false;
+
+		// set once the section was written out and released in streaming mode,
+		// so that stale writers throw instead of writing into reused memory
+		bool closed = false;
+
+		// the section is placed so that `offset + bias` is a multiple of `alignment`,
+		// `padding` holds the number of zero bytes written in front of it to achieve that
+		uint32_t alignment = 1;
+		uint32_t bias = 0;
+		uint32_t padding = 0;
+
+		// start of the key column set with `index()`, zero if there is none
+		uint32_t indexed = 0;
+
+		// the first section found to be identical to this one, including
+		// all the sections it links to, set to itself if there is none
+		SectionBuffer* canonical = this;
+
+		// the section that links to this one and the index of that link,
+		// used by the streaming mode to back-patch the parent when this section is written
+		SectionBuffer* parent = nullptr;
+		uint32_t slot = 0;
+
+		// both arrays live in the arena of the owning manager,
+		// when they need to grow they are moved to a bigger arena block
+		// and the old one is released for reuse
+		SectionArena* arena;
+
+		uint8_t* data = nullptr;
+		uint32_t length = 0;
+		uint32_t capacity = 0;
+
+		Link* links = nullptr;
+		uint32_t link_count = 0;
+		uint32_t link_capacity = 0;
 
 		// FIXME
 		friend class SectionCache;
+		friend class SectionManager;
+		friend class SectionStream;
+
+		/// make sure there is space for at least `size` more bytes
+		void reserve(size_t size);
+
+		/// returns the data and link arrays back to the arena
+		void release();
+
+	public:
+
+		SectionBuffer(SectionArena* arena);
 
 	public:
 
-		/// calculates the hash of this section, needs to be called after all the mutating calls like `write()` or `set()`
-		void finalize(int bytes);
+		/// calculates the hash of this section's data, needs to be called after all the mutating calls like `write()` or `set()`
+		void finalize();
 
-		/// checks if this section is equal to the data at offset in the output array
-		bool equal(std::vector<uint8_t>& output, uint32_t offset);
+		/// includes the hashes of the linked sections in the hash of this section, all
+		/// linked sections need to be identified first, needs to be called *after* `finalize()`
+		void identify();
+
+		/// checks if this section contains the same data and links to the same (or identical) sections as the other section
+		bool equal(const SectionBuffer* other) const;
+
+		/// returns the first offset not before the given one that satisfies the alignment of this section
+		uint32_t aligned(uint32_t offset) const;
 
 	public:
 
@@ -75,6 +186,14 @@ class SectionBuffer {
 
 	public:
 
+		/// Requests the byte at `bias` within this section to be placed at an offset that is a multiple of
+		/// `alignment` in the output, the alignment needs to be a power of two not larger than 64
+		void align(uint32_t alignment, uint32_t bias = 0);
+
+		/// Marks all data from `start` onwards as a column of [u16 key][u32 value] records, that
+		/// are put in key order by `finalize()`, records with equal keys are ordered by value
+		void index(uint32_t start);
+
 		/// Removes the last byte from the container
 		void pop();
 
@@ -84,14 +203,21 @@ class SectionBuffer {
 		/// writes `size` bytes from `bytes` array
 		void write(const void* bytes, size_t size);
 
+		/// appends `size` uninitialized bytes and returns a pointer to them, the pointer
+		/// is only valid until the next mutating call and is not aligned in any way
+		uint8_t* extend(size_t size);
+
 		/// copies the `bytes` array into an alredy existing data at offset
 		void set(uint32_t offset, const void* bytes, size_t size);
 
-		/// copies the data from this section into the output buffer
-		void emit(std::vector<uint8_t>& output);
+		/// inserts `size` bytes at the given offset, moving the following data and links forward
+		void insert(uint32_t offset, const void* bytes, size_t size);
 
-		/// insert linkages to other sections, all data needs to be alredy emitted into the output
-		void link(std::vector<uint8_t>& output);
+		/// returns the data of this section, the links are only valid after `patch()`
+		std::span<const uint8_t> bytes() const;
+
+		/// insert linkages to other sections into this section's data, all sections need to have their offsets assigned
+		void patch();
 
 	public:
 
@@ -102,34 +228,61 @@ class SectionBuffer {
 
 };
 
+class SectionStream;
+
 class SectionCache {
 
 	private:
 
 		struct SectionInfo {
 
-			uint32_t length = 0;
-			uint32_t offset = 0;
 			uint64_t hashed = 0;
+			uint32_t length = 0; // zero marks an empty slot
+			uint32_t offset = 0;
+			SectionBuffer* buffer = nullptr;
 
 			SectionInfo() = default;
 			SectionInfo(SectionBuffer* buffer);
 
 		};
 
-		// each bucket containes only one cached value
-		SectionInfo bucket[0xFF + 1];
+		// open addressing table with linear probing, the
+		// capacity is always a power of two not larger than `limit`
+		std::vector<SectionInfo> table;
+		size_t count = 0;
+		size_t limit;
 		bool enabled;
 
+		// after this many probes the home slot is replaced instead
+		static constexpr size_t max_probes = 16;
+
+		// in streaming mode the cached sections are no longer in memory
+		// and need to be compared against the already written output
+		SectionStream* stream;
+
 		WriteResult stats;
 
+		/// doubles the capacity of the table and re-inserts all entries
+		void grow();
+
+		/// returns the cached section identical to the buffer and true, or the slot
+		/// the buffer should be inserted into (if any) and false
+		std::pair<SectionInfo*, bool> lookup(SectionBuffer* buffer);
+
 	public:
 
-		SectionCache(bool enabled);
+		SectionCache(SectionStream* stream = nullptr);
+
+		/// clears the table and statistics for the next emit, keeping the table's memory if possible
+		void prepare(const WriteConfig& config, size_t expected);
 
-		/// wrapped for the `buffer.emit()` call that tries to limit the number of those calls
-		/// by mapping identical sections to the same memory range
-		void emit(SectionBuffer* buffer, std::vector<uint8_t>& output);
+		/// assigns the output offset to the buffer, tries to limit the number of written sections
+		/// by mapping identical sections to the same memory range, `end` is advanced past any written section
+		void place(SectionBuffer* buffer, uint32_t& end);
+
+		/// sets the canonical section of the buffer to the first identical section passed to this method,
+		/// all sections linked from the buffer need to be resolved first
+		void resolve(SectionBuffer* buffer);
 
 		/// returns some general statistics about the
 		/// written data, see the `WriteResult` struct
@@ -137,21 +290,144 @@ class SectionCache {
 
 };
 
+class SectionStream {
+
+	private:
+
+		OutputFile& output;
+		SectionCache cache;
+
+		// sections are staged here and written in bigger batches,
+		// `flushed` is the offset of the first staged byte
+		std::vector<uint8_t> pending;
+		std::vector<uint8_t> scratch;
+		uint32_t flushed;
+
+		static constexpr size_t batch_size = 64 * 1024;
+
+	public:
+
+		SectionStream(OutputFile& output, uint32_t base, const WriteConfig& config);
+
+		/// assigns the output offset to the buffer and stages its data if it was not already written
+		void place(SectionBuffer* buffer);
+
+		/// compares the bytes with the data already staged or written at the given offset
+		bool equal(uint32_t offset, std::span<const uint8_t> bytes);
+
+		/// returns the offset just past the last staged byte
+		uint32_t size() const;
+
+		/// writes all staged data into the output
+		void flush();
+
+		/// returns the statistics of the underlying cache
+		WriteResult result() const;
+
+};
+
 class SectionManager {
 
 	private:
 
+		// all buffers and their data is freed at once when the arena is destroyed
+		SectionArena arena;
 		std::vector<SectionBuffer*> buffers;
+		SectionCache cache;
+		int allocations = 0;
+
+		// only used in streaming mode, where no list of buffers is kept
+		// and sections are released as soon as they are written
+		std::unique_ptr<SectionStream> stream;
+		OutputFile* output = nullptr;
+		SectionBuffer* root = nullptr;
+
+		// closed buffers are only reused for new buffers, and in the order they were closed,
+		// so their `closed` flag stays set for as long as possible to catch stale writers
+		std::deque<SectionBuffer*> recycled;
+		WriteConfig config;
+
+		// the block table and the data of a single block, kept between
+		// emits so that compressing doesn't allocate once warmed up
+		std::vector<BlockEntry> entries;
+		std::vector<uint8_t> plain;
+		std::vector<uint8_t> packed;
+
+		// marks sections that have no offset assigned during layout
+		static constexpr uint32_t unplaced = 0xFFFFFFFF;
+
+		/// Assigns final offsets to all sections starting at `base` and patches the links in place,
+		/// returns the offset just past the last written section
+		uint32_t layout(uint32_t base, const WriteConfig& config, WriteResult& result);
+
+		/// Copies the header and all written sections into the output, the sections need to be laid out first,
+		/// the section at offset `origin` is copied to the start of the output
+		void copy(uint8_t* output, size_t start, uint32_t base, const WriteConfig& config, uint32_t origin = 0);
+
+		/// Writes the header, block table and the compressed sections through `write(offset, data, size)`, the
+		/// sections need to be laid out first, the table is written twice, with placeholder offsets before
+		/// the blocks and complete after them, returns the number of bytes in the compressed output
+		template <typename F>
+		size_t compress(size_t start, uint32_t base, const WriteConfig& config, F write);
+
+		/// Writes all the remaining children of this section, then the section itself, into the stream,
+		/// returns the offset at which the section was placed
+		uint32_t flush(SectionBuffer* buffer);
+
+		/// Returns the flags for the header of output written with the given config, the layout
+		/// flags and `UNIQUE_SECTIONS` if the sections are not deduplicated
+		uint16_t headerFlags(const WriteConfig& config) const;
 
 	public:
 
-		/// free buffers, maybe replace with std::unique_ptrs?
-		~SectionManager();
+		SectionManager() = default;
+
+		/// Creates a manager that builds the sections according to the layout options of the config
+		explicit SectionManager(const WriteConfig& config);
+
+		/// Creates a streaming manager, that writes each section into the output as soon as it is closed,
+		/// instead of keeping all of them in memory until `emit()`, call `finish()` once the tree is complete
+		SectionManager(OutputFile& output, const WriteConfig& config = {});
+
+	public:
 
 		/// Returns a pointer to a newly allocated Section Buffer
 		SectionBuffer* allocate();
 
+		/// Returns the header flags describing the layout of the sections built by this manager
+		uint16_t flags() const;
+
+		/// Returns the alignment of the first element of arrays with elements of the given size
+		uint32_t alignment(uint32_t size) const;
+
+		/// Marks the section as complete, in streaming mode the section and all its not yet closed
+		/// children are written out and released, so they must not be modified after this call,
+		/// modifying or closing them again throws, until the memory is reused by a new section
+		void close(SectionBuffer* buffer);
+
+		/// Writes all remaining sections and the header, can only be used in streaming mode
+		WriteResult finish();
+
+		/// Drops all sections but keeps the allocated memory, so that writing a similar tree
+		/// again doesn't need to allocate, all previously returned buffers become invalid
+		void reset();
+
 		/// Emits all the stored data into the output vector in accordance with the WriteConfig
 		WriteResult emit(std::vector<uint8_t>& output, const WriteConfig& config = {});
 
+		/// Emits all the stored data without the header into the output vector, as if the vector was placed at offset `base`
+		/// of an existing file, used for appending sections to a file, the root section is placed first, right at `base`
+		WriteResult emit(std::vector<uint8_t>& output, uint32_t base, const WriteConfig& config);
+
+		/// Emits all the stored data into the given fixed buffer, if it is too small nothing is
+		/// written and the `overflow` flag in the result is set instead of raising an exception,
+		/// compression keeps its scratch buffers between emits, so only the first one allocates
+		WriteResult emit(std::span<uint8_t> output, const WriteConfig& config = {});
+
+		/// Emits all the stored data into the file without copying it into an intermediate buffer
+		WriteResult emit(OutputFile& output, const WriteConfig& config = {});
+
+		/// Emits all the stored data into a temporary file that then atomically replaces the file at `path`
+		WriteResult emit(const std::string& path, const WriteConfig& config = {});
+
 };
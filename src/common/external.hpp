@@ -5,13 +5,36 @@
 #include <cstdint>
 #include <cstddef>
 #include <cstring>
+#include <cstdlib>
 
 // C++
 #include <string>
 #include <vector>
+#include <deque>
+#include <array>
 #include <stdexcept>
 #include <algorithm>
 #include <bit>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <span>
+#include <ranges>
 #include <iostream>
+#include <thread>
+#include <atomic>
+
+// SIMD
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+// wider instructions are only used after checking the CPU at runtime
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LIB_FORMAT_RUNTIME_AVX2
+#include <immintrin.h>
+#endif
@@ -3,16 +3,60 @@
 
 #ifdef _WIN32
 #	include <windows.h>
+#	include <io.h>
+#	include <fcntl.h>
+#	include <sys/stat.h>
 #else
 #	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <sys/uio.h>
+#	include <climits>
+#	include <cerrno>
 #	include <fcntl.h>
 #	include <unistd.h>
 #endif
 
-InputFile::InputFile(const std::string& path)
+InputFile::InputFile(const std::string& path, const InputConfig& config)
 : file_data(nullptr), file_size(0) {
 
+	// standard input can't be mapped, so it is always read
+	if (path == "-") {
 #ifdef _WIN32
+		_setmode(_fileno(stdin), _O_BINARY);
+		load(_fileno(stdin), 0, config);
+#else
+		load(STDIN_FILENO, 0, config);
+#endif
+		return;
+	}
+
+#ifdef _WIN32
+	if (config.read_below > 0) {
+		int handle = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+
+		if (handle == -1) {
+			throw std::runtime_error {"open: Failed open file"};
+		}
+
+		__int64 size = _lseeki64(handle, 0, SEEK_END);
+
+		if (size >= 0 && (size_t) size < config.read_below) {
+			_lseeki64(handle, 0, SEEK_SET);
+
+			try {
+				load(handle, size, config);
+			} catch (...) {
+				_close(handle);
+				throw;
+			}
+
+			_close(handle);
+			return;
+		}
+
+		_close(handle);
+	}
+
 	HANDLE file_handle = CreateFileA(path.c_str(), GENERIC_READ, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
 
 	if (file_handle == INVALID_HANDLE_VALUE) {
@@ -48,25 +92,60 @@ InputFile::InputFile(const std::string& path)
 		throw std::runtime_error {"open: Failed open file"};
 	}
 
-	this->file_size = lseek(file, 0, SEEK_END);
+	struct stat info;
+
+	if (fstat(file, &info) == -1) {
+		close(file);
+		throw std::runtime_error {"fstat: Failed get file size"};
+	}
+
+	// pipes and devices can't be mapped, and neither can empty files
+	if (!S_ISREG(info.st_mode) || (size_t) info.st_size < config.read_below || info.st_size == 0) {
+		try {
+			load(file, S_ISREG(info.st_mode) ? info.st_size : 0, config);
+		} catch (...) {
+			close(file);
+			throw;
+		}
 
-	if (file_size == -1) {
 		close(file);
-		throw std::runtime_error {"lseek: Failed get file size"};
+		return;
 	}
 
-	this->file_data = (uint8_t*) mmap(NULL, file_size, PROT_READ, MAP_SHARED, file, 0);
+	int flags = MAP_SHARED;
+
+#ifdef MAP_POPULATE
+	if (config.populate) {
+		flags |= MAP_POPULATE;
+	}
+#endif
+
+	this->file_size = info.st_size;
+	this->file_data = (uint8_t*) mmap(NULL, file_size, PROT_READ, flags, file, 0);
 	close(file);
 
 	if (file_data == MAP_FAILED) {
+		this->file_data = nullptr;
 		throw std::runtime_error {"mmap: Failed to map view of file"};
 	}
+
+#ifdef MADV_HUGEPAGE
+	if (config.huge_pages) {
+		madvise(file_data, file_size, MADV_HUGEPAGE);
+	}
+#endif
+
+	if (config.advice != InputAdvice::NORMAL) {
+		advise(0, file_size, config.advice);
+	}
 #endif
 
 }
 
 InputFile::~InputFile() {
-	if (file_data) {
+	if (file_data && buffered) {
+		::operator delete(file_data, std::align_val_t {buffered});
+	} else if (file_data) {
 #ifdef _WIN32
 		UnmapViewOfFile(file_data);
 #else
@@ -77,6 +156,74 @@ InputFile::~InputFile() {
 	file_data = nullptr;
 }
 
+void InputFile::load(int handle, size_t size, const InputConfig& config) {
+
+	// the buffer keeps the alignment a mapping would have, so that aligned data
+	// can still be used in place, big buffers can be backed by huge pages
+	size_t alignment = 4096;
+	size_t capacity = std::max<size_t>(size, 64 * 1024);
+
+	if (config.huge_pages && capacity >= 2 * 1024 * 1024) {
+		alignment = 2 * 1024 * 1024;
+	}
+
+	uint8_t* buffer = static_cast<uint8_t*>(::operator new(capacity, std::align_val_t {alignment}));
+	size_t length = 0;
+
+	auto release = [&] () {
+		::operator delete(buffer, std::align_val_t {alignment});
+	};
+
+	while (true) {
+
+		// the size of streams is not known, so the buffer grows as needed
+		if (length == capacity) {
+			uint8_t* larger = static_cast<uint8_t*>(::operator new(capacity * 2, std::align_val_t {alignment}));
+			memcpy(larger, buffer, length);
+			release();
+
+			buffer = larger;
+			capacity *= 2;
+		}
+
+#ifdef _WIN32
+		int count = _read(handle, buffer + length, (unsigned int) std::min<size_t>(capacity - length, INT_MAX));
+#else
+		ssize_t count = read(handle, buffer + length, capacity - length);
+
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+#endif
+
+		if (count < 0) {
+			release();
+			throw std::runtime_error {"read: Failed to read file"};
+		}
+
+		if (count == 0) {
+			break;
+		}
+
+		length += count;
+
+		// regular files are read up to their known size, there is no need to grow the buffer just to see the end
+		if (size != 0 && length == size) {
+			break;
+		}
+	}
+
+#ifdef MADV_HUGEPAGE
+	if (alignment > 4096) {
+		madvise(buffer, capacity, MADV_HUGEPAGE);
+	}
+#endif
+
+	this->file_data = buffer;
+	this->file_size = length;
+	this->buffered = alignment;
+}
+
 const uint8_t* InputFile::data() const {
 	return file_data;
 }
@@ -84,3 +231,473 @@ const uint8_t* InputFile::data() const {
 size_t InputFile::size() const {
 	return file_size;
 }
+
+bool InputFile::mapped() const {
+	return !buffered;
+}
+
+void InputFile::advise(size_t offset, size_t size, uint8_t advice) {
+	if (buffered || offset >= file_size) {
+		return;
+	}
+
+#ifndef _WIN32
+	int hint = POSIX_MADV_NORMAL;
+
+	if (advice == InputAdvice::SEQUENTIAL) hint = POSIX_MADV_SEQUENTIAL;
+	if (advice == InputAdvice::RANDOM) hint = POSIX_MADV_RANDOM;
+	if (advice == InputAdvice::WILLNEED) hint = POSIX_MADV_WILLNEED;
+
+	// the range has to start on a page boundary
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t start = offset & ~(page - 1);
+	size = std::min(size, file_size - offset) + (offset - start);
+
+	// this is only a hint, so errors are ignored
+	posix_madvise(file_data + start, size, hint);
+#endif
+}
+
+UpdateFile::UpdateFile(const std::string& path)
+: file_data(nullptr), file_size(0) {
+
+#ifdef _WIN32
+	this->handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (handle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error {"CreateFileA: Failed to open file"};
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size)) {
+		CloseHandle(handle);
+		throw std::runtime_error {"GetFileSizeEx: Failed to get file size"};
+	}
+
+	this->file_size = static_cast<size_t>(size.QuadPart);
+#else
+	this->handle = open(path.c_str(), O_RDWR);
+
+	if (handle == -1) {
+		throw std::runtime_error {"open: Failed open file"};
+	}
+
+	struct stat info;
+
+	if (fstat(handle, &info) == -1 || !S_ISREG(info.st_mode)) {
+		close(handle);
+		throw std::runtime_error {"fstat: Only regular files can be updated"};
+	}
+
+	this->file_size = info.st_size;
+#endif
+
+	try {
+		map();
+	} catch (...) {
+#ifdef _WIN32
+		CloseHandle(handle);
+#else
+		close(handle);
+#endif
+		throw;
+	}
+
+}
+
+UpdateFile::~UpdateFile() {
+	unmap();
+
+#ifdef _WIN32
+	CloseHandle(handle);
+#else
+	close(handle);
+#endif
+}
+
+void UpdateFile::map() {
+
+	// empty files can't be mapped
+	if (file_size == 0) {
+		return;
+	}
+
+#ifdef _WIN32
+	HANDLE map_handle = CreateFileMapping(handle, NULL, PAGE_READWRITE, 0, 0, NULL);
+
+	if (!map_handle) {
+		throw std::runtime_error {"CreateFileMapping: Failed to create file mapping"};
+	}
+
+	this->file_data = (uint8_t*) MapViewOfFile(map_handle, FILE_MAP_WRITE, 0, 0, file_size);
+	CloseHandle(map_handle);
+
+	if (!file_data) {
+		throw std::runtime_error {"MapViewOfFile: Failed to map view of file"};
+	}
+#else
+	this->file_data = (uint8_t*) mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+
+	if (file_data == MAP_FAILED) {
+		this->file_data = nullptr;
+		throw std::runtime_error {"mmap: Failed to map view of file"};
+	}
+#endif
+
+}
+
+void UpdateFile::unmap() {
+	if (file_data) {
+#ifdef _WIN32
+		UnmapViewOfFile(file_data);
+#else
+		munmap(file_data, file_size);
+#endif
+	}
+
+	file_data = nullptr;
+}
+
+uint8_t* UpdateFile::data() {
+	return file_data;
+}
+
+size_t UpdateFile::size() const {
+	return file_size;
+}
+
+void UpdateFile::append(const void* data, size_t size) {
+	const uint8_t* bytes = (const uint8_t*) data;
+	size_t offset = file_size;
+	size_t remaining = size;
+
+#ifdef _WIN32
+	while (remaining > 0) {
+		OVERLAPPED position {};
+		position.Offset = (DWORD) offset;
+		position.OffsetHigh = (DWORD) ((uint64_t) offset >> 32);
+
+		DWORD written = 0;
+
+		if (!WriteFile(handle, bytes, (DWORD) std::min<size_t>(remaining, INT_MAX), &written, &position) || written == 0) {
+			throw std::runtime_error {"WriteFile: Failed to append to file"};
+		}
+
+		bytes += written;
+		offset += written;
+		remaining -= written;
+	}
+#else
+	while (remaining > 0) {
+		ssize_t written = pwrite(handle, bytes, remaining, offset);
+
+		if (written <= 0) {
+			if (written < 0 && errno == EINTR) continue;
+			throw std::runtime_error {"pwrite: Failed to append to file"};
+		}
+
+		bytes += written;
+		offset += written;
+		remaining -= written;
+	}
+#endif
+
+	// the mapping can't grow in place, so the file is mapped again
+	unmap();
+	this->file_size = offset;
+	map();
+}
+
+void UpdateFile::sync() {
+
+#ifdef _WIN32
+	if (file_data) {
+		FlushViewOfFile(file_data, 0);
+	}
+
+	FlushFileBuffers(handle);
+#else
+	if (file_data && msync(file_data, file_size, MS_SYNC) == -1) {
+		throw std::runtime_error {"msync: Failed to flush file"};
+	}
+
+	if (fsync(handle) == -1) {
+		throw std::runtime_error {"fsync: Failed to flush file"};
+	}
+#endif
+
+}
+
+RandomFile::RandomFile(const std::string& path)
+: file_size(0) {
+
+#ifdef _WIN32
+	this->handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (handle == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error {"CreateFileA: Failed to open file"};
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size)) {
+		CloseHandle(handle);
+		throw std::runtime_error {"GetFileSizeEx: Failed to get file size"};
+	}
+
+	this->file_size = static_cast<size_t>(size.QuadPart);
+#else
+	this->handle = open(path.c_str(), O_RDONLY);
+
+	if (handle == -1) {
+		throw std::runtime_error {"open: Failed open file"};
+	}
+
+	struct stat info;
+
+	if (fstat(handle, &info) == -1 || !S_ISREG(info.st_mode)) {
+		close(handle);
+		throw std::runtime_error {"fstat: Only regular files can be read in pages"};
+	}
+
+	this->file_size = info.st_size;
+#endif
+
+}
+
+RandomFile::~RandomFile() {
+#ifdef _WIN32
+	CloseHandle(handle);
+#else
+	close(handle);
+#endif
+}
+
+size_t RandomFile::size() const {
+	return file_size;
+}
+
+void RandomFile::read(uint64_t offset, void* data, size_t size) const {
+	if (offset > file_size || size > file_size - offset) {
+		throw std::runtime_error {"read: Range lies outside of the file"};
+	}
+
+#ifdef _WIN32
+	while (size > 0) {
+		OVERLAPPED position {};
+		position.Offset = (DWORD) offset;
+		position.OffsetHigh = (DWORD) (offset >> 32);
+
+		DWORD count = 0;
+
+		if (!ReadFile(handle, data, (DWORD) std::min<size_t>(size, INT_MAX), &count, &position) || count == 0) {
+			throw std::runtime_error {"ReadFile: Failed to read file"};
+		}
+
+		data = (uint8_t*) data + count;
+		offset += count;
+		size -= count;
+	}
+#else
+	while (size > 0) {
+		ssize_t count = pread(handle, data, size, offset);
+
+		if (count <= 0) {
+			if (count < 0 && errno == EINTR) continue;
+			throw std::runtime_error {"pread: Failed to read file"};
+		}
+
+		data = (uint8_t*) data + count;
+		offset += count;
+		size -= count;
+	}
+#endif
+
+}
+
+OutputFile::OutputFile(const std::string& path)
+: handle(-1), owned(true), path(path) {
+
+#ifdef _WIN32
+	this->temp = path + ".tmp";
+	this->handle = _open(temp.c_str(), _O_RDWR | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	std::string pattern = path + ".XXXXXX";
+	this->handle = mkstemp(pattern.data());
+	this->temp = pattern;
+
+	// mkstemp() creates the file with 0600
+	if (handle != -1) {
+		fchmod(handle, 0644);
+	}
+#endif
+
+	if (handle == -1) {
+		throw std::runtime_error {"open: Failed to create temporary file"};
+	}
+
+}
+
+OutputFile::OutputFile(int handle)
+: handle(handle), owned(false) {}
+
+OutputFile::~OutputFile() {
+	if (owned && handle != -1) {
+#ifdef _WIN32
+		_close(handle);
+		_unlink(temp.c_str());
+#else
+		close(handle);
+		unlink(temp.c_str());
+#endif
+	}
+}
+
+void OutputFile::write(const void* data, size_t size) {
+	Slice slice {(const uint8_t*) data, size};
+	write(std::span {&slice, 1});
+}
+
+void OutputFile::write(std::span<const Slice> slices) {
+
+#ifdef _WIN32
+	for (Slice slice : slices) {
+		const uint8_t* data = slice.data();
+		size_t remaining = slice.size();
+
+		while (remaining > 0) {
+			int written = _write(handle, data, (unsigned int) std::min<size_t>(remaining, INT_MAX));
+
+			if (written <= 0) {
+				throw std::runtime_error {"write: Failed to write file"};
+			}
+
+			data += written;
+			remaining -= written;
+		}
+	}
+#else
+	iovec batch[IOV_MAX];
+	size_t next = 0;
+
+	while (next < slices.size()) {
+		int count = 0;
+
+		while (count < IOV_MAX && next < slices.size()) {
+			batch[count].iov_base = (void*) slices[next].data();
+			batch[count].iov_len = slices[next].size();
+
+			count ++;
+			next ++;
+		}
+
+		iovec* head = batch;
+
+		// writev() can return early, in that case resume after the last written byte
+		while (count > 0) {
+			ssize_t written = writev(handle, head, count);
+
+			if (written < 0) {
+				if (errno == EINTR) continue;
+				throw std::runtime_error {"writev: Failed to write file"};
+			}
+
+			while (count > 0 && (size_t) written >= head->iov_len) {
+				written -= head->iov_len;
+				head ++;
+				count --;
+			}
+
+			if (count > 0) {
+				head->iov_base = (uint8_t*) head->iov_base + written;
+				head->iov_len -= written;
+			}
+		}
+	}
+#endif
+
+}
+
+void OutputFile::patch(uint64_t offset, const void* data, size_t size) {
+
+#ifdef _WIN32
+	__int64 end = _lseeki64(handle, 0, SEEK_CUR);
+	_lseeki64(handle, offset, SEEK_SET);
+	int written = _write(handle, data, (unsigned int) size);
+	_lseeki64(handle, end, SEEK_SET);
+
+	if (written != (int) size) {
+		throw std::runtime_error {"write: Failed to patch file"};
+	}
+#else
+	while (size > 0) {
+		ssize_t written = pwrite(handle, data, size, offset);
+
+		if (written <= 0) {
+			if (written < 0 && errno == EINTR) continue;
+			throw std::runtime_error {"pwrite: Failed to patch file"};
+		}
+
+		data = (const uint8_t*) data + written;
+		offset += written;
+		size -= written;
+	}
+#endif
+
+}
+
+void OutputFile::read(uint64_t offset, void* data, size_t size) {
+
+#ifdef _WIN32
+	__int64 end = _lseeki64(handle, 0, SEEK_CUR);
+	_lseeki64(handle, offset, SEEK_SET);
+	int count = _read(handle, data, (unsigned int) size);
+	_lseeki64(handle, end, SEEK_SET);
+
+	if (count != (int) size) {
+		throw std::runtime_error {"read: Failed to read back file"};
+	}
+#else
+	while (size > 0) {
+		ssize_t count = pread(handle, data, size, offset);
+
+		if (count <= 0) {
+			if (count < 0 && errno == EINTR) continue;
+			throw std::runtime_error {"pread: Failed to read back file"};
+		}
+
+		data = (uint8_t*) data + count;
+		offset += count;
+		size -= count;
+	}
+#endif
+
+}
+
+void OutputFile::commit() {
+	if (!owned || handle == -1) {
+		return;
+	}
+
+#ifdef _WIN32
+	_commit(handle);
+	_close(handle);
+	this->handle = -1;
+
+	if (!MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		_unlink(temp.c_str());
+		throw std::runtime_error {"MoveFileExA: Failed to replace file"};
+	}
+#else
+	if (fsync(handle) == -1) {
+		throw std::runtime_error {"fsync: Failed to flush file"};
+	}
+
+	close(handle);
+	this->handle = -1;
+
+	if (rename(temp.c_str(), path.c_str()) == -1) {
+		unlink(temp.c_str());
+		throw std::runtime_error {"rename: Failed to replace file"};
+	}
+#endif
+}
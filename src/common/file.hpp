@@ -2,6 +2,37 @@
 #pragma once
 #include "external.hpp"
 
+/// hints about how a range of a mapped file is going to be accessed
+struct InputAdvice {
+
+	enum : uint8_t {
+		NORMAL     = 0, // no special treatment
+		SEQUENTIAL = 1, // read ahead aggressively, pages can be dropped soon after they were used
+		RANDOM     = 2, // don't read ahead, only the touched pages are loaded
+		WILLNEED   = 3, // start loading the range in the background right away
+	};
+
+};
+
+struct InputConfig {
+
+	// controls whether all the pages are loaded when the file is mapped,
+	// instead of being faulted in one by one when they are first touched
+	bool populate = false;
+
+	// the expected access pattern of the whole file, see `InputAdvice`
+	uint8_t advice = InputAdvice::NORMAL;
+
+	// controls whether to ask for transparent huge pages, this only has an
+	// effect if the system supports them for the file or for the read buffer
+	bool huge_pages = false;
+
+	// files smaller than this many bytes are read into a buffer instead of being mapped,
+	// pipes, standard input (passed as "-") and other streams are always read this way
+	size_t read_below = 0;
+
+};
+
 class InputFile {
 
 	private:
@@ -9,12 +40,140 @@ class InputFile {
 		uint8_t* file_data;
 		size_t file_size;
 
+		// set if the data was read into a buffer instead of being mapped,
+		// holds the alignment the buffer was allocated with
+		size_t buffered = 0;
+
+		/// reads everything from the descriptor into a newly allocated buffer, `size` is the expected size or zero if unknown
+		void load(int handle, size_t size, const InputConfig& config);
+
 	public:
 
-		InputFile(const std::string& path);
+		InputFile(const std::string& path, const InputConfig& config = {});
 		~InputFile();
 
+		InputFile(const InputFile&) = delete;
+		InputFile& operator=(const InputFile&) = delete;
+
 		const uint8_t* data() const;
 		size_t size() const;
 
+		/// returns true if the file is mapped, and false if it was read into a buffer
+		bool mapped() const;
+
+		/// passes the access hint for the given range to the system, the range is clamped to
+		/// the file, does nothing if the file was read into a buffer or hints are not supported
+		void advise(size_t offset, size_t size, uint8_t advice);
+
+};
+
+/// an existing file opened for reading and writing, the whole file is mapped writable, so it can
+/// be modified in place, data can only be added at the end, which moves the mapping to a new address
+class UpdateFile {
+
+	private:
+
+		uint8_t* file_data;
+		size_t file_size;
+
+#ifdef _WIN32
+		void* handle;
+#else
+		int handle;
+#endif
+
+		/// maps the first `file_size` bytes of the file
+		void map();
+
+		/// releases the current mapping
+		void unmap();
+
+	public:
+
+		UpdateFile(const std::string& path);
+		~UpdateFile();
+
+		UpdateFile(const UpdateFile&) = delete;
+		UpdateFile& operator=(const UpdateFile&) = delete;
+
+		uint8_t* data();
+		size_t size() const;
+
+		/// writes `size` bytes at the end of the file, this invalidates all pointers returned by `data()`
+		void append(const void* data, size_t size);
+
+		/// flushes all the changes made so far to disk
+		void sync();
+
+};
+
+/// a file that is read with positional reads, without mapping it, for hosts where mappings are restricted,
+/// or files too large for the address space, the reads are independent, so it can be shared between threads
+class RandomFile {
+
+	private:
+
+		size_t file_size;
+
+#ifdef _WIN32
+		void* handle;
+#else
+		int handle;
+#endif
+
+	public:
+
+		RandomFile(const std::string& path);
+		~RandomFile();
+
+		RandomFile(const RandomFile&) = delete;
+		RandomFile& operator=(const RandomFile&) = delete;
+
+		size_t size() const;
+
+		/// copies `size` bytes starting at `offset` into the buffer, the range needs to lie within the file
+		void read(uint64_t offset, void* data, size_t size) const;
+
+};
+
+class OutputFile {
+
+	private:
+
+		int handle;
+		bool owned;
+
+		// the file is written under a temporary name and
+		// only moved into place once `commit()` is called
+		std::string path;
+		std::string temp;
+
+	public:
+
+		using Slice = std::span<const uint8_t>;
+
+		/// creates a temporary file next to `path`
+		OutputFile(const std::string& path);
+
+		/// wraps an already open descriptor, the descriptor is not closed and `commit()` does nothing
+		OutputFile(int handle);
+
+		/// removes the temporary file if the output was not commited
+		~OutputFile();
+
+		/// writes `size` bytes at the end of the file
+		void write(const void* data, size_t size);
+
+		/// writes all the slices at the end of the file using scatter-gather calls
+		void write(std::span<const Slice> slices);
+
+		/// overwrites `size` bytes at the given offset, the data needs to already be written
+		void patch(uint64_t offset, const void* data, size_t size);
+
+		/// reads back `size` bytes from the given offset, the data needs to already be written
+		void read(uint64_t offset, void* data, size_t size);
+
+		/// flushes the file to disk and atomically replaces the file at the target path
+		void commit();
+
 };
@@ -0,0 +1,201 @@
+
+#include "classify.hpp"
+
+/// the classes of each byte value, one bit for each field of `TokenMasks`, in order
+static constexpr auto classes = [] () {
+	std::array<uint8_t, 256> table {};
+
+	for (int chr = 0; chr < 256; chr ++) {
+		bool alphanumeric = (chr >= '0' && chr <= '9') || (chr >= 'a' && chr <= 'z') || (chr >= 'A' && chr <= 'Z');
+
+		table[chr] |= (alphanumeric || chr == '_' || chr == '-' || chr == '.') << 0;
+		table[chr] |= (chr == ' ' || chr == '\n' || chr == '\t' || chr == '\r') << 1;
+		table[chr] |= (chr == '"') << 2;
+		table[chr] |= (chr == '\\') << 3;
+		table[chr] |= (chr == '\n') << 4;
+		table[chr] |= (chr == '\0') << 5;
+		table[chr] |= (chr == '*') << 6;
+		table[chr] |= (chr == '/') << 7;
+	}
+
+	return table;
+}();
+
+static TokenMasks classifyScalar(const char* block) {
+	uint64_t masks[8] = {};
+
+	// classes of 8 bytes at a time, the multiplication gathers one bit of each byte into the top byte
+	for (int i = 0; i < 64; i += 8) {
+		uint64_t bits = 0;
+
+		for (int j = 0; j < 8; j ++) {
+			bits |= (uint64_t) classes[(uint8_t) block[i + j]] << (j * 8);
+		}
+
+		for (int j = 0; j < 8; j ++) {
+			masks[j] |= (((bits >> j) & 0x0101010101010101) * 0x0102040810204080 >> 56) << i;
+		}
+	}
+
+	return {masks[0], masks[1], masks[2], masks[3], masks[4], masks[5], masks[6], masks[7]};
+}
+
+#if defined(__SSE2__)
+static TokenMasks classifySSE2(const char* block) {
+	TokenMasks masks {};
+
+	for (int i = 0; i < 64; i += 16) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+
+		auto is = [&] (char chr) {
+			return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(chr));
+		};
+
+		// signed compares leave out all the bytes above 0x7F, and the letters are checked once by setting the case bit
+		auto within = [] (__m128i value, char low, char high) {
+			return _mm_and_si128(_mm_cmpgt_epi8(value, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(value, _mm_set1_epi8(high + 1)));
+		};
+
+		__m128i letter = within(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'z');
+		__m128i word = _mm_or_si128(_mm_or_si128(letter, within(bytes, '0', '9')), _mm_or_si128(is('_'), _mm_or_si128(is('-'), is('.'))));
+		__m128i white = _mm_or_si128(_mm_or_si128(is(' '), is('\n')), _mm_or_si128(is('\t'), is('\r')));
+
+		auto bits = [] (__m128i mask) {
+			return (uint64_t) (uint32_t) _mm_movemask_epi8(mask);
+		};
+
+		masks.word |= bits(word) << i;
+		masks.white |= bits(white) << i;
+		masks.quote |= bits(is('"')) << i;
+		masks.backslash |= bits(is('\\')) << i;
+		masks.newline |= bits(is('\n')) << i;
+		masks.nul |= bits(is('\0')) << i;
+		masks.star |= bits(is('*')) << i;
+		masks.slash |= bits(is('/')) << i;
+	}
+
+	return masks;
+}
+#endif
+
+#if defined(LIB_FORMAT_RUNTIME_AVX2)
+// same as for SSE2, but there is no 'less than' compare, so the arguments are swapped
+__attribute__((target("avx2")))
+static inline __m256i within(__m256i value, char low, char high) {
+	return _mm256_and_si256(_mm256_cmpgt_epi8(value, _mm256_set1_epi8(low - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), value));
+}
+
+__attribute__((target("avx2")))
+static inline uint64_t bits(__m256i mask) {
+	return (uint32_t) _mm256_movemask_epi8(mask);
+}
+
+__attribute__((target("avx2")))
+static TokenMasks classifyAVX2(const char* block) {
+	TokenMasks masks {};
+
+	for (int i = 0; i < 64; i += 32) {
+		__m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+
+		auto is = [&] (char chr) __attribute__((target("avx2"))) {
+			return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(chr));
+		};
+
+		__m256i letter = within(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 'z');
+		__m256i word = _mm256_or_si256(_mm256_or_si256(letter, within(bytes, '0', '9')), _mm256_or_si256(is('_'), _mm256_or_si256(is('-'), is('.'))));
+		__m256i white = _mm256_or_si256(_mm256_or_si256(is(' '), is('\n')), _mm256_or_si256(is('\t'), is('\r')));
+
+		masks.word |= bits(word) << i;
+		masks.white |= bits(white) << i;
+		masks.quote |= bits(is('"')) << i;
+		masks.backslash |= bits(is('\\')) << i;
+		masks.newline |= bits(is('\n')) << i;
+		masks.nul |= bits(is('\0')) << i;
+		masks.star |= bits(is('*')) << i;
+		masks.slash |= bits(is('/')) << i;
+	}
+
+	return masks;
+}
+#endif
+
+/// the names of all implementations, from the widest
+static constexpr const char* implementations[] = {"avx2", "sse2", "scalar"};
+
+/// picks the implementation for this CPU, and its name, an implementation
+/// can be requested explicitly, if it's not supported the default is used
+static std::pair<TokenMasks::Classifier, const char*> select() {
+	const char* requested = getenv("LIB_FORMAT_CLASSIFIER");
+
+	for (const char* name : implementations) {
+		TokenMasks::Classifier classifier = TokenMasks::classifier(name);
+
+		if (classifier && requested && name == std::string_view {requested}) {
+			return {classifier, name};
+		}
+	}
+
+	for (const char* name : implementations) {
+		if (TokenMasks::Classifier classifier = TokenMasks::classifier(name)) {
+			return {classifier, name};
+		}
+	}
+
+	return {classifyScalar, "scalar"};
+}
+
+TokenMasks::Classifier TokenMasks::classifier(std::string_view name) {
+#if defined(LIB_FORMAT_RUNTIME_AVX2)
+	if (name == "avx2") {
+		return __builtin_cpu_supports("avx2") ? classifyAVX2 : nullptr;
+	}
+#endif
+
+#if defined(__SSE2__)
+	if (name == "sse2") {
+		return classifySSE2;
+	}
+#endif
+
+	if (name == "scalar") {
+		return classifyScalar;
+	}
+
+	return nullptr;
+}
+
+TokenMasks::Classifier TokenMasks::classifier() {
+	static const auto selected = select();
+	return selected.first;
+}
+
+const char* TokenMasks::implementation() {
+	static const auto selected = select();
+	return selected.second;
+}
+
+TokenBlocks::TokenBlocks(const char* data, size_t size, TokenMasks::Classifier classify)
+: data(data), size(size), classify(classify) {}
+
+TokenMasks TokenBlocks::load(size_t index) const {
+	size_t offset = index * 64;
+
+	if (offset + 64 <= size) {
+		return classify(data + offset);
+	}
+
+	char block[64] = {};
+
+	if (offset < size) {
+		memcpy(block, data + offset, size - offset);
+	}
+
+	return classify(block);
+}
+
+void TokenBlocks::move(size_t index) {
+	current = (this->index != SIZE_MAX && index == this->index + 1) ? following : load(index);
+	following = load(index + 1);
+
+	this->index = index;
+}
@@ -0,0 +1,93 @@
+
+#pragma once
+#include <common/external.hpp>
+
+/// the character classes of 64 consecutive bytes, bit N stands for the byte at offset N
+struct TokenMasks {
+
+	uint64_t word;   // letters, digits and joints
+	uint64_t white;  // spaces, tabs and line breaks
+	uint64_t quote;
+	uint64_t backslash;
+	uint64_t newline;
+	uint64_t nul;
+	uint64_t star;
+	uint64_t slash;
+
+	using Classifier = TokenMasks (*) (const char* block);
+
+	/// returns the function that classifies 64 bytes with the widest instructions this CPU supports, or the one
+	/// named by the `LIB_FORMAT_CLASSIFIER` environment variable, the choice is made once, on the first call
+	static Classifier classifier();
+
+	/// returns the implementation with the given name ("avx2", "sse2" or "scalar"),
+	/// or null if it was not built in or this CPU doesn't support it
+	static Classifier classifier(std::string_view name);
+
+	/// returns the name of the implementation returned by `classifier()`
+	static const char* implementation();
+
+};
+
+/// walks the input in blocks of 64 bytes, keeping the masks of the current block and the one after it, so that
+/// conditions on the following byte can be checked across block boundaries, bytes past the end read as zero
+class TokenBlocks {
+
+	private:
+
+		const char* data;
+		size_t size;
+
+		TokenMasks::Classifier classify;
+		size_t index = SIZE_MAX;
+		TokenMasks current;
+		TokenMasks following;
+
+		/// classifies the block with the given index, copying it first if it extends past the end
+		TokenMasks load(size_t index) const;
+
+		/// makes the block with the given index the current one
+		void move(size_t index);
+
+	public:
+
+		TokenBlocks(const char* data, size_t size, TokenMasks::Classifier classify = TokenMasks::classifier());
+
+		/// returns the offset of the first byte at or after `offset` that is selected by the function, which is
+		/// called with the masks of a block and of the one after it, returns a value not less than `size` if there
+		/// is no such byte, `line` and `last` are advanced over the new lines skipped before the returned offset
+		template <typename F>
+		size_t find(size_t offset, F select, int& line, int& last) {
+			while (offset < size) {
+				size_t block = offset / 64;
+
+				if (block != index) {
+					move(block);
+				}
+
+				uint64_t range = ~0ull << (offset % 64);
+				uint64_t stop = select(current, following) & range;
+				uint64_t skipped = stop ? range & ((1ull << std::countr_zero(stop)) - 1) : range;
+				uint64_t lines = current.newline & skipped;
+
+				if (lines) {
+					line += std::popcount(lines);
+					last = block * 64 + 63 - std::countl_zero(lines);
+				}
+
+				if (stop) {
+					return block * 64 + std::countr_zero(stop);
+				}
+
+				offset = (block + 1) * 64;
+			}
+
+			return size;
+		}
+
+		/// returns the mask with each bit set if the byte after it is set in `mask`
+		static uint64_t after(uint64_t mask, uint64_t next) {
+			return (mask >> 1) | (next << 63);
+		}
+
+};
@@ -0,0 +1,177 @@
+
+#include "document.hpp"
+
+TextTreeDocument::TextTreeDocument(const char* data, int size) {
+	std::vector<Token> tokens = Token::tokenize(data, size);
+
+	if (tokens.empty()) {
+		throw ParseError {"Nothing to load", 1, 1};
+	}
+
+	// tokens must not be empty
+	TokenSpan span {tokens};
+
+	if (span.size() < 2) {
+		span.last().expected("enclosing brace pair");
+	}
+
+	if (!span.get(0).isSymbolEqual('{')) {
+		span.get(0).expected("'{'");
+	}
+
+	if (!span.last().isSymbolEqual('}')) {
+		span.last().expected("'}'");
+	}
+
+	// each cell comes from a different token, so the tape never needs to grow
+	// past this, which keeps the pointers from lists and dicts into it valid
+	tape.reserve(tokens.size());
+
+	TextTreeNode root = parseDict(span.unpack());
+	tape.push_back(root);
+
+	items = {};
+	entries = {};
+}
+
+TextTreeNode TextTreeDocument::parseValue(TokenParser& parser) {
+
+	TokenSpan span = parser.nextValue();
+
+	if (span.size() == 1) {
+		return parsePrimitive(span.get(0));
+	}
+
+	if (span.size() >= 2) {
+		TokenSpan unpacked = span.unpack();
+
+		if (span.get(0).isSymbolEqual('[')) {
+			return parseList(unpacked);
+		}
+
+		if (span.get(0).isSymbolEqual('{')) {
+			return parseDict(unpacked);
+		}
+	}
+
+	// this shouldn't ever happen
+	throw std::runtime_error {"Failed to parse value"};
+
+}
+
+TextTreeNode TextTreeDocument::parsePrimitive(const Token& token) {
+
+	bool isTrue = (token.view() == "true");
+	bool isFalse = (token.view() == "false");
+
+	if (isTrue || isFalse) {
+		return TextTreeBool {isTrue};
+	}
+
+	if (token.type == Token::STRING) {
+		return TextTreeString {token.view()};
+	}
+
+	double dv;
+	long lv;
+
+	std::string copy (token.view());
+
+	if (TextTreeInt::tryParse(&lv, copy)) {
+		return TextTreeInt {lv};
+	}
+
+	if (TextTreeNumber::tryParse(&dv, copy)) {
+		return TextTreeNumber {dv};
+	}
+
+	// this can happen
+	token.expected("valid primitive value");
+}
+
+TextTreeNode TextTreeDocument::parseList(TokenSpan span) {
+
+	TokenParser parser {span};
+	size_t base = items.size();
+
+	while (parser.remaining() > 0) {
+		TextTreeNode item = parseValue(parser);
+		items.push_back(item);
+		parser.consumeSeparator();
+	}
+
+	TextTreeNode list {TextTreeTag::LIST};
+	list.length = items.size() - base;
+	list.first = tape.data() + tape.size();
+
+	tape.insert(tape.end(), items.begin() + base, items.end());
+	items.erase(items.begin() + base, items.end());
+
+	return list;
+}
+
+TextTreeNode TextTreeDocument::parseDict(TokenSpan span) {
+
+	TokenParser parser {span};
+	size_t base = entries.size();
+
+	// small dicts are checked for duplicates directly, the set is only filled once there are more entries
+	std::unordered_set<std::string_view> keys;
+
+	auto contains = [&] (std::string_view key) {
+		size_t count = entries.size() - base;
+
+		if (count < 32) {
+			return std::any_of(entries.begin() + base, entries.end(), [&] (const auto& entry) {
+				return entry.first == key;
+			});
+		}
+
+		if (keys.empty()) {
+			for (size_t i = base; i < entries.size(); i ++) {
+				keys.insert(entries[i].first);
+			}
+		}
+
+		return !keys.insert(key).second;
+	};
+
+	while (parser.remaining() > 0) {
+
+		const Token& name = parser.nextToken();
+		std::string_view key = name.view();
+
+		if (name.type != Token::WORD) {
+			name.expected("property name");
+		}
+
+		if (contains(key)) {
+			name.expected("unique property name");
+		}
+
+		TextTreeNode value = parseValue(parser);
+		entries.emplace_back(key, value);
+		parser.consumeSeparator();
+	}
+
+	std::sort(entries.begin() + base, entries.end(), [] (const auto& left, const auto& right) {
+		return left.first < right.first;
+	});
+
+	TextTreeNode dict {TextTreeTag::DICT};
+	dict.length = entries.size() - base;
+	dict.first = tape.data() + tape.size();
+
+	for (size_t i = base; i < entries.size(); i ++) {
+		tape.push_back(TextTreeString {entries[i].first});
+		tape.push_back(entries[i].second);
+	}
+
+	entries.erase(entries.begin() + base, entries.end());
+	return dict;
+
+}
+
+const TextTreeDict* TextTreeDocument::root() const {
+	return tape.back().as<TextTreeDict>();
+}
@@ -0,0 +1,37 @@
+
+#pragma once
+#include <common/external.hpp>
+
+#include "parser.hpp"
+#include "nodes.hpp"
+
+/// holds all nodes of a parsed file in one contiguous tape of cells, the items of each list and the
+/// entries of each dict (a key followed by its value) are placed one after another, the entries sorted
+/// by key, the nodes are views into the tape, so they are all released at once with the document
+class TextTreeDocument {
+
+	private:
+
+		std::vector<TextTreeNode> tape;
+
+		// the items of the lists and the entries of the dicts that are still being parsed, once
+		// a list or dict is complete its part is moved to the tape, so it ends up contiguous
+		std::vector<TextTreeNode> items;
+		std::vector<std::pair<std::string_view, TextTreeNode>> entries;
+
+		TextTreeNode parseValue(TokenParser& parser);
+		TextTreeNode parsePrimitive(const Token& token);
+		TextTreeNode parseList(TokenSpan span);
+		TextTreeNode parseDict(TokenSpan span);
+
+	public:
+
+		/// tokenizes and parses the text, the strings are not copied, so
+		/// it needs to outlive the document, may throw ParseError
+		TextTreeDocument(const char* data, int size);
+
+		TextTreeDocument(const TextTreeDocument&) = delete;
+
+		const TextTreeDict* root() const;
+
+};
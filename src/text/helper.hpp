@@ -1,7 +1,7 @@
 
 #pragma once
 #include <common/file.hpp>
-#include "nodes.hpp"
+#include "document.hpp"
 
 struct TextTree {
 
@@ -10,42 +10,16 @@ struct TextTree {
 		private:
 
 			InputFile file;
-			const TextTreeDict* node;
+			TextTreeDocument document;
 
 		public:
 
-			Input(const std::string& path)
-			: file(path.c_str()) {
-				std::vector<Token> tokens = Token::tokenize((const char*) file.data(), file.size());
-
-				if (tokens.empty()) {
-					throw ParseError {"Nothing to load", 1, 1};
-				}
-
-				// tokens must not be empty
-				TokenSpan span {tokens};
-
-				if (span.size() < 2) {
-					span.last().expected("enclosing brace pair");
-				}
-
-				if (!span.get(0).isSymbolEqual('{')) {
-					span.get(0).expected("'{'");
-				}
-
-				if (!span.last().isSymbolEqual('}')) {
-					span.last().expected("'}'");
-				}
-
-				this->node = TextTreeDict::parse(span.unpack());
-			}
-
-			~Input() {
-				delete node;
-			}
+			/// reads the file, the `config` controls how it is mapped, see `InputConfig`, use "-" to read standard input
+			Input(const std::string& path, const InputConfig& config = {})
+			: file(path, config), document((const char*) file.data(), file.size()) {}
 
 			const TextTreeDict* root() {
-				return node;
+				return document.root();
 			}
 
 	};
@@ -9,13 +9,13 @@ void visit(const TextTreeNode* node, int depth, std::vector<bool> flags = {}) {
 		int count = dict->size();
 		std::cout << "Dictionary (" << count << " entries)\n";
 
-		for (auto& [key, value] : *dict) {
+		for (auto [key, value] : *dict) {
 			std::vector<bool> child {flags};
 			child.push_back(-- count);
 
 			padding(child);
 			std::cout << key << " ";
-			visit(value.get(), depth, child);
+			visit(value, depth, child);
 		}
 	}
 
@@ -24,13 +24,13 @@ void visit(const TextTreeNode* node, int depth, std::vector<bool> flags = {}) {
 		int index = 0;
 		std::cout << "List (" << count << " entries)\n";
 
-		for (auto& value : *list) {
+		for (auto value : *list) {
 			std::vector<bool> child {flags};
 			child.push_back(-- count);
 
 			padding(child);
 			std::cout << (index ++) << " ";
-			visit(value.get(), depth, child);
+			visit(value, depth, child);
 		}
 	}
 
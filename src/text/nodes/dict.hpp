@@ -6,50 +6,80 @@ class TextTreeDict : public TextTreeNode {
 
 	private:
 
-		std::unordered_map<std::string_view, std::unique_ptr<const TextTreeNode>> nodes;
+		/// returns the key of the entry at the given index
+		std::string_view key(int index) const {
+			return *first[index * 2].as<TextTreeString>();
+		}
+
+		/// returns the value stored under the key, the entries are sorted by their keys
+		const TextTreeNode* find(std::string_view key) const {
+			int low = 0;
+			int high = size();
+
+			while (low < high) {
+				int middle = low + (high - low) / 2;
+				std::string_view current = this->key(middle);
+
+				if (current == key) {
+					return first + middle * 2 + 1;
+				}
+
+				if (current < key) {
+					low = middle + 1;
+				} else {
+					high = middle;
+				}
+			}
+
+			return nullptr;
+		}
 
 	public:
 
-		static constexpr const char* name = "dictionary";
+		class Iterator {
 
-		static inline const TextTreeDict* parse(TokenSpan span) {
+			private:
 
-			TokenParser parser {span};
-			TextTreeDict* dict = new TextTreeDict;
+				const TextTreeNode* cell;
 
-			while (parser.remaining() > 0) {
+			public:
 
-				const Token& name = parser.nextToken();
-				std::string_view key = name.view();
+				Iterator(const TextTreeNode* cell)
+				: cell(cell) {}
 
-				if (name.type != Token::WORD) {
-					name.expected("property name");
+				std::pair<std::string_view, const TextTreeNode*> operator*() const {
+					return {*cell->as<TextTreeString>(), cell + 1};
 				}
 
-				if (dict->nodes.contains(key)) {
-					name.expected("unique property name");
+				Iterator& operator++() {
+					cell += 2;
+					return *this;
 				}
 
-				dict->nodes.emplace(key, parseValue(parser));
-				parser.consumeSeparator();
-			}
+				bool operator==(const Iterator& other) const = default;
 
-			return dict;
+		};
 
+	public:
+
+		static constexpr const char* name = "dictionary";
+
+		static bool accepts(uint8_t tag) {
+			return tag == TextTreeTag::DICT;
 		}
 
 	public:
 
 		int size() const {
-			return nodes.size();
+			return length;
 		}
 
 		template <std::derived_from<TextTreeNode> T = TextTreeNode>
 		const T* getNullable(std::string_view key) const {
-			auto it = nodes.find(key);
+			const TextTreeNode* node = find(key);
 
-			if (it != nodes.end()) {
-				return dynamic_cast<const T*>(it->second.get());
+			if (node) {
+				return node->as<T>();
 			}
 
 			return nullptr;
@@ -66,13 +96,13 @@ class TextTreeDict : public TextTreeNode {
 			return node;
 		}
 
-		auto begin() const {
-			return nodes.begin();
+		/// iterates the key and value pairs, ordered by key
+		Iterator begin() const {
+			return first;
 		}
 
-		auto end() const {
-			return nodes.end();
+		Iterator end() const {
+			return first + length * 2;
 		}
 
-
 };
@@ -4,37 +4,50 @@
 
 class TextTreeList : public TextTreeNode {
 
-	private:
+	public:
 
-		std::vector<std::unique_ptr<const TextTreeNode>> nodes;
+		class Iterator {
 
-	public:
+			private:
 
-		static constexpr const char* name = "list";
+				const TextTreeNode* cell;
 
-		static inline const TextTreeList* parse(TokenSpan span) {
+			public:
 
-			TokenParser parser {span};
-			TextTreeList* list = new TextTreeList;
+				Iterator(const TextTreeNode* cell)
+				: cell(cell) {}
 
-			while (parser.remaining() > 0) {
-				list->nodes.emplace_back(parseValue(parser));
-				parser.consumeSeparator();
-			}
+				const TextTreeNode* operator*() const {
+					return cell;
+				}
+
+				Iterator& operator++() {
+					cell ++;
+					return *this;
+				}
+
+				bool operator==(const Iterator& other) const = default;
+
+		};
+
+	public:
+
+		static constexpr const char* name = "list";
 
-			return list;
+		static bool accepts(uint8_t tag) {
+			return tag == TextTreeTag::LIST;
 		}
 
 	public:
 
 		int size() const {
-			return nodes.size();
+			return length;
 		}
 
 		template <std::derived_from<TextTreeNode> T = TextTreeNode>
 		const T* getNullable(int index) const {
-			if (index < nodes.size()) {
-				return dynamic_cast<const T*>(nodes[index].get());
+			if (index >= 0 && index < size()) {
+				return first[index].as<T>();
 			}
 
 			return nullptr;
@@ -51,12 +64,13 @@ class TextTreeList : public TextTreeNode {
 			return node;
 		}
 
-		auto begin() const {
-			return nodes.begin();
+		/// iterates the items in order, yielding pointers like the dictionary iterator
+		Iterator begin() const {
+			return first;
 		}
 
-		auto end() const {
-			return nodes.end();
+		Iterator end() const {
+			return first + length;
 		}
 
 };
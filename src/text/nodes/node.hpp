@@ -2,21 +2,54 @@
 #pragma once
 #include <common/external.hpp>
 
+struct TextTreeTag {
+	enum : uint8_t {
+		BOOL,
+		INT,
+		NUMBER,
+		STRING,
+		LIST,
+		DICT
+	};
+};
+
+/// a single 16 byte cell of a `TextTreeDocument`, the node classes add no members of their
+/// own, they only give a typed view of the cell, so type checks are done by comparing the tag
 class TextTreeNode {
 
+	friend class TextTreeDocument;
+
 	protected:
 
-		static inline const TextTreeNode* parseValue(TokenParser& parser);
+		uint8_t tag;
+
+		// the length of a string, or the number of list items or dict entries
+		uint32_t length = 0;
+
+		union {
+			bool boolean;
+			long integer;
+			double number;
+			const char* string;
+			const TextTreeNode* first; // the first item of a list or the first key of a dict
+		};
+
+		TextTreeNode(uint8_t tag)
+		: tag(tag), integer(0) {}
 
 	public:
 
 		static constexpr const char* name = "any";
 
-		virtual ~TextTreeNode() = default;
+		static bool accepts(uint8_t) {
+			return true;
+		}
 
 		template <std::derived_from<TextTreeNode> T = TextTreeNode>
 		const T* as() const {
-			return dynamic_cast<const T*>(this);
+			return T::accepts(tag) ? static_cast<const T*>(this) : nullptr;
 		}
 
 };
+
+static_assert(sizeof(TextTreeNode) == 16);
@@ -4,61 +4,75 @@
 
 class TextTreeValue : public TextTreeNode {
 
+	protected:
+
+		using TextTreeNode::TextTreeNode;
+
 	public:
 
 		static constexpr const char* name = "primitive";
 
-		static inline const TextTreeValue* parse(TokenSpan span);
+		static bool accepts(uint8_t tag) {
+			return tag <= TextTreeTag::STRING;
+		}
 
 };
 
 class TextTreeBool : public TextTreeValue {
 
-	private:
-
-		bool value;
-
 	public:
 
 		static constexpr const char* name = "bool";
 
+		static bool accepts(uint8_t tag) {
+			return tag == TextTreeTag::BOOL;
+		}
+
 		TextTreeBool(bool value)
-		: value(value) {}
+		: TextTreeValue(TextTreeTag::BOOL) {
+			this->boolean = value;
+		}
 
 		operator bool() const {
-			return value;
+			return boolean;
 		}
 
 };
 
 class TextTreeString : public TextTreeValue {
 
-	private:
-
-		std::string_view value;
-
 	public:
 
 		static constexpr const char* name = "string";
 
+		static bool accepts(uint8_t tag) {
+			return tag == TextTreeTag::STRING;
+		}
+
 		TextTreeString(std::string_view value)
-		: value(value) {}
+		: TextTreeValue(TextTreeTag::STRING) {
+			this->string = value.data();
+			this->length = value.size();
+		}
 
 		operator std::string_view() const {
-			return value;
+			return {string, length};
 		}
 
 		std::string copy() const {
-			return std::string {value};
+			return std::string {string, length};
 		}
 
 };
 
 class TextTreeNumber : public TextTreeValue {
 
-	private:
+	protected:
 
-		double value;
+		TextTreeNumber(long value, uint8_t tag)
+		: TextTreeValue(tag) {
+			this->integer = value;
+		}
 
 	public:
 
@@ -86,15 +100,22 @@ class TextTreeNumber : public TextTreeValue {
 
 		static constexpr const char* name = "number";
 
+		// integers are numbers too
+		static bool accepts(uint8_t tag) {
+			return tag == TextTreeTag::NUMBER || tag == TextTreeTag::INT;
+		}
+
 		TextTreeNumber(double value)
-		: value(value) {}
+		: TextTreeValue(TextTreeTag::NUMBER) {
+			this->number = value;
+		}
 
 		operator double() const {
-			return value;
+			return tag == TextTreeTag::INT ? (double) integer : number;
 		}
 
 		operator float() const {
-			return (float) value;
+			return (float) (double) *this;
 		}
 
 };
@@ -103,8 +124,6 @@ class TextTreeInt : public TextTreeNumber {
 
 	private:
 
-		long value;
-
 		// otherwise the int conversion is ambiguous
 		operator double() const = delete;
 		operator float() const = delete;
@@ -135,15 +154,19 @@ class TextTreeInt : public TextTreeNumber {
 
 		static constexpr const char* name = "integer";
 
+		static bool accepts(uint8_t tag) {
+			return tag == TextTreeTag::INT;
+		}
+
 		TextTreeInt(long value)
-		: TextTreeNumber(value), value(value) {}
+		: TextTreeNumber(value, TextTreeTag::INT) {}
 
 		operator long() const {
-			return value;
+			return integer;
 		}
 
 		operator int() const {
-			return value;
+			return integer;
 		}
 
 };
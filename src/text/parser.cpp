@@ -1,26 +1,6 @@
 
 #include "parser.hpp"
 
-int TokenParser::countUntilBalanced(char open, char close) {
-	int depth = 1;
-	int count = 0;
-
-	while (depth > 0) {
-		const Token& token = nextToken();
-		count ++;
-
-		if (token.isSymbolEqual(open)) {
-			depth ++;
-		}
-
-		if (token.isSymbolEqual(close)) {
-			depth --;
-		}
-	}
-
-	return count;
-}
-
 TokenParser::TokenParser(TokenSpan span)
 : span(span), index(0) {}
 
@@ -38,17 +18,24 @@ const Token& TokenParser::nextToken() {
 
 TokenSpan TokenParser::nextValue() {
 	int start = index;
-	int length = 1;
-
 	const Token& first = nextToken();
 
 	if (first.type == Token::SYMBOL) {
-		     if (first.isSymbolEqual('[')) length += countUntilBalanced('[', ']');
-		else if (first.isSymbolEqual('{')) length += countUntilBalanced('{', '}');
-		else first.expected("property value");
+		if (!first.isSymbolEqual('[') && !first.isSymbolEqual('{')) {
+			first.expected("property value");
+		}
+
+		// the tokenizer already matched the brackets, so the nested tokens are skipped at once
+		int end = span.closing(start);
+
+		if (end == -1) {
+			span.last().raise("Unexpected end of scope");
+		}
+
+		index = end + 1;
 	}
 
-	return span.sub(start, start + length);
+	return span.sub(start, index);
 }
 
 void TokenParser::consumeSeparator() {
@@ -11,9 +11,6 @@ class TokenParser {
 		TokenSpan span;
 		int index;
 
-		/// returns the distance from the opening bracket to the equallibrium
-		int countUntilBalanced(char open, char close);
-
 	public:
 
 		TokenParser(TokenSpan span);
@@ -27,6 +27,16 @@ bool TokenSpan::empty() const {
 	return size() == 0;
 }
 
+int TokenSpan::closing(int index) const {
+	int match = get(index).match;
+
+	if (match < start || match >= end) {
+		return -1;
+	}
+
+	return match - start;
+}
+
 TokenSpan TokenSpan::sub(int from, int to) const {
 	int child_start = start + from;
 	int child_end = start + to;
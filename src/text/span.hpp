@@ -34,6 +34,9 @@ class TokenSpan {
 		/// returns true if this span contains no tokens
 		bool empty() const;
 
+		/// returns the index of the bracket closing the one at the given index, or -1 if it's not within this span
+		int closing(int index) const;
+
 		/// returns a subspan of this span starting including 'from' but excluding 'to'
 		TokenSpan sub(int from, int to) const;
 
@@ -69,6 +69,13 @@ std::vector<Token> Token::tokenize(const char* start, int size) {
 
 	std::vector<Token> tokens;
 
+	// typical trees have a token every few bytes, this avoids most of the reallocations
+	tokens.reserve(size / 8);
+
+	// indices of the brackets that are still open, each kind is matched on its own
+	std::vector<int> squares;
+	std::vector<int> curlies;
+
 	enum {
 		OUTER,
 		WORD,
@@ -76,36 +83,62 @@ std::vector<Token> Token::tokenize(const char* start, int size) {
 		COMMENT
 	} state = OUTER;
 
-	int last = size - 1;
+	// the bytes each state needs to look at, all the others are skipped 64 at a time, only
+	// counting new lines, `after()` selects the bytes followed by the ones in the mask
+	auto outer = [] (const TokenMasks& masks, const TokenMasks& next) {
+		return ~masks.white | TokenBlocks::after(masks.word, next.word);
+	};
+
+	auto word = [] (const TokenMasks& masks, const TokenMasks& next) {
+		return ~TokenBlocks::after(masks.word, next.word);
+	};
+
+	auto quoted = [] (const TokenMasks& masks, const TokenMasks&) {
+		return masks.quote | masks.backslash | masks.newline | masks.nul;
+	};
+
+	auto comment = [] (const TokenMasks& masks, const TokenMasks& next) {
+		return masks.star & TokenBlocks::after(masks.slash, next.slash);
+	};
+
+	TokenBlocks blocks {start, (size_t) std::max(size, 0)};
+
 	int line = 1;
-	int column = 1;
+	int last = -1; // the offset of the last new line
 
 	int begin = 0;
+	int i = 0;
+
+	while (true) {
 
-	for (int i = 0; i < size; i ++) {
+		if (state == OUTER) i = blocks.find(i, outer, line, last);
+		if (state == WORD) i = blocks.find(i, word, line, last);
+		if (state == STRING) i = blocks.find(i, quoted, line, last);
+		if (state == COMMENT) i = blocks.find(i, comment, line, last);
+
+		if (i >= size) {
+			break;
+		}
 
 		char c = *(start + i);
-		char n = (i == last) ? 0 : *(start + i + 1);
+		char n = (i == size - 1) ? 0 : *(start + i + 1);
+		int column = i - last + 1;
 
 		// keep track of the position in the input file
 		if (c == '\n') {
 			line ++;
+			last = i;
 			column = 1;
-		} else {
-			column ++;
 		}
 
 		// outside and specific token
 		// looks at the next character to switch states, emits symbol tokens
 		if (state == OUTER) {
 
-			// begin comment
+			// begin comment, skip the '*'
 			if (c == '/' && n == '*') {
 				state = COMMENT;
-
-				// skip the '*'
-				i ++;
-				column ++;
+				i += 2;
 				continue;
 			}
 
@@ -113,6 +146,7 @@ std::vector<Token> Token::tokenize(const char* start, int size) {
 			if (c == '"') {
 				begin = i + 1;
 				state = STRING;
+				i ++;
 				continue;
 			}
 
@@ -120,20 +154,31 @@ std::vector<Token> Token::tokenize(const char* start, int size) {
 			if (isWord(n)) {
 				begin = i + 1;
 				state = WORD;
+				i ++;
 				continue;
 			}
 
 			// check for symbols
 			if (isSymbol(c)) {
+				int index = tokens.size();
 				tokens.emplace_back(start + i, 1, Token::SYMBOL, line, column);
-				continue;
-			}
 
-			// don't care
-			if (isWhite(c)) {
+				if (c == '[') squares.push_back(index);
+				if (c == '{') curlies.push_back(index);
+
+				std::vector<int>& open = (c == ']') ? squares : curlies;
+
+				// unmatched closing brackets are left for the parser to report
+				if ((c == ']' || c == '}') && !open.empty()) {
+					tokens[open.back()].match = index;
+					open.pop_back();
+				}
+
+				i ++;
 				continue;
 			}
 
+			// white characters are skipped by the blocks
 			throw ParseError {"Unexpected " + identify(c) + " in scope", line, column};
 
 		}
@@ -146,10 +191,7 @@ std::vector<Token> Token::tokenize(const char* start, int size) {
 			if (isWhite(n) || isSymbol(n)) {
 				tokens.emplace_back(start + begin, i - begin + 1, Token::WORD, line, column);
 				state = OUTER;
-				continue;
-			}
-
-			if (isWord(n)) {
+				i ++;
 				continue;
 			}
 
@@ -158,21 +200,11 @@ std::vector<Token> Token::tokenize(const char* start, int size) {
 		}
 
 		// comment, emits no tokens
-		// consumes characters until '*/' is found
+		// stops at the '*/', skips the '/'
 		if (state == COMMENT) {
-
-			if (c == '*' && n == '/') {
-				state = OUTER;
-
-				// skip the '/'
-				i ++;
-				column ++;
-				continue;
-			}
-
-			// no throw here; we accept all character in comments
+			state = OUTER;
+			i += 2;
 			continue;
-
 		}
 
 		// strings, emits string tokens
@@ -186,22 +218,18 @@ std::vector<Token> Token::tokenize(const char* start, int size) {
 				}
 
 				// skip the escaped character
-				i ++;
-				column ++;
+				i += 2;
 				continue;
 			}
 
 			if (c == '"') {
 				tokens.emplace_back(start + begin, i - begin, Token::STRING, line, column);
 				state = OUTER;
+				i ++;
 				continue;
 			}
 
 			// no new lines and null bytes in strings
-			if (c != '\n' && c != '\0') {
-				continue;
-			}
-
 			throw ParseError {"Unexpected " + identify(c) + " in string", line, column};
 
 		}
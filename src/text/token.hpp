@@ -3,6 +3,7 @@
 #include <common/external.hpp>
 
 #include "error.hpp"
+#include "classify.hpp"
 
 struct Token {
 
@@ -20,6 +21,9 @@ struct Token {
 		int line;
 		int column;
 
+		// the index of the matching closing bracket for '[' and '{', -1 for other tokens and unclosed brackets
+		int match = -1;
+
 	public:
 
 		/// raise parse error with a custom message
@@ -0,0 +1,143 @@
+
+#include <binary/helper.hpp>
+
+// every heap allocation made by the process goes through here
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+	allocations ++;
+
+	if (void* pointer = malloc(size)) {
+		return pointer;
+	}
+
+	throw std::bad_alloc {};
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+// over-aligned types, like the arena blocks, are allocated through these
+void* operator new(size_t size, std::align_val_t alignment) {
+	allocations ++;
+
+	// the size given to aligned_alloc() needs to be a multiple of the alignment
+	size_t align = (size_t) alignment;
+
+	if (void* pointer = aligned_alloc(align, (size + align - 1) / align * align)) {
+		return pointer;
+	}
+
+	throw std::bad_alloc {};
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+	free(pointer);
+}
+
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+	free(pointer);
+}
+
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+	free(pointer);
+}
+
+/// builds a tree like the ones serialized every frame, the values change between frames but the shape stays the same
+static void build(SectionManager& manager, int frame) {
+	BinaryTreeNode::Writer root {&manager, manager.allocate()};
+	auto dict = root.as<BinaryTreeDict>();
+
+	dict.put(0).as<BinaryTreeInt>(frame);
+	dict.put(1).as<BinaryTreeText>(frame % 2 ? "odd" : "even");
+
+	auto entities = dict.put(2).as<BinaryTreeArray<BinaryTreeDict>>();
+
+	for (int i = 0; i < 500; i ++) {
+		auto entity = entities.put();
+		entity.put(0).as<BinaryTreeText>("entity");
+		entity.put(1).as<BinaryTreeInt>(i * frame);
+		entity.put(2).as<BinaryTreeVec3f>(i, frame, 0);
+	}
+
+	auto lookup = dict.put(3).as<BinaryTreeMap>();
+
+	for (int i = 0; i < 100; i ++) {
+		lookup.put(i * 3).as<BinaryTreeFloat>(i + frame);
+	}
+}
+
+int main() {
+	SectionManager manager;
+	std::vector<uint8_t> output (1024 * 1024);
+
+	WriteConfig compressed;
+	compressed.compression = true;
+
+	for (const WriteConfig& config : {WriteConfig {}, compressed}) {
+		for (int frame = 0; frame < 16; frame ++) {
+			manager.reset();
+
+			size_t before = allocations;
+			build(manager, frame);
+			WriteResult result = manager.emit(std::span {output}, config);
+			size_t count = allocations - before;
+
+			if (result.overflow) {
+				std::cout << "Frame " << frame << " didn't fit into the output buffer" << std::endl;
+				return 1;
+			}
+
+			// the first frame warms up the arena, buffer list, cache table and compression buffers
+			if (frame > 0 && count != 0) {
+				std::cout << "Frame " << frame << " made " << count << " heap allocations (" << result.allocations << " reported), expected none" << std::endl;
+				return 1;
+			}
+
+			BinaryTree::Input input {std::span<const uint8_t> {output.data(), result.size}, true};
+
+			if ((int) input.root().as<BinaryTreeDict>().get(0).as<BinaryTreeInt>() != frame) {
+				std::cout << "Frame " << frame << " was not written correctly" << std::endl;
+				return 1;
+			}
+		}
+	}
+
+	// a buffer that is too small is reported, not thrown
+	uint8_t small[16];
+	manager.reset();
+	build(manager, 1);
+
+	if (!manager.emit(std::span {small}).overflow) {
+		std::cout << "Expected an overflow for a small buffer" << std::endl;
+		return 1;
+	}
+
+	std::cout << "No allocations after warm-up" << std::endl;
+	return 0;
+}
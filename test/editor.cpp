@@ -0,0 +1,283 @@
+
+#include <binary/helper.hpp>
+#include <filesystem>
+#include <functional>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+	if (!condition) {
+		std::cout << "Failed: " << what << std::endl;
+		failures ++;
+	}
+}
+
+/// returns true if the function throws a runtime error
+template <typename F>
+static bool throws(F function) {
+	try {
+		function();
+	} catch (const std::runtime_error&) {
+		return true;
+	}
+
+	return false;
+}
+
+/// describes the node, so that values of any type can be compared as strings
+static std::string describe(BinaryTreeNode node) {
+	if (node.is<BinaryTreeInt>()) return std::to_string((int) node.as<BinaryTreeInt>());
+	if (node.is<BinaryTreeDouble>()) return std::to_string((double) node.as<BinaryTreeDouble>());
+	if (node.is<BinaryTreeText>()) return node.as<BinaryTreeText>().copy();
+
+	if (node.is<BinaryTreeVec3f>()) {
+		BinaryVector<float, 3> vector = node.as<BinaryTreeVec3f>();
+		return std::to_string((int) vector[0]) + "," + std::to_string((int) vector[1]) + "," + std::to_string((int) vector[2]);
+	}
+
+	return node.name();
+}
+
+/// reopens the file, validating it as a whole, and describes the value at the path
+static std::string value(const std::string& path, const char* query) {
+	BinaryTree::Input input {path, true};
+	auto nodes = BinaryTreeQuery {query}.find(input.root());
+
+	return nodes.empty() ? "none" : describe(nodes[0]);
+}
+
+/// writes a tree with every kind of container, each one holding values that can be replaced
+static void build(SectionManager& manager) {
+	BinaryTreeNode::Writer root {&manager, manager.allocate()};
+	auto dict = root.as<BinaryTreeDict>();
+
+	dict.put(1).as<BinaryTreeInt>(10);
+	dict.put(2).as<BinaryTreeDouble>(2.5);
+
+	auto nested = dict.put(3).as<BinaryTreeDict>();
+	nested.put(7).as<BinaryTreeText>("seven");
+	nested.put(8).as<BinaryTreeInt>(8);
+	nested.put(9).as<BinaryTreeVec3f>(1, 2, 3);
+
+	auto ints = dict.put(4).as<BinaryTreeArray<BinaryTreeInt>>();
+
+	for (int i = 0; i < 10; i ++) {
+		ints.put(i);
+	}
+
+	auto map = dict.put(5).as<BinaryTreeMap>();
+
+	for (int i = 0; i < 1000; i ++) {
+		map.put(i * 3).as<BinaryTreeInt>(i);
+	}
+
+	auto dicts = dict.put(6).as<BinaryTreeArray<BinaryTreeDict>>();
+
+	for (int i = 0; i < 3; i ++) {
+		dicts.put().put(1).as<BinaryTreeInt>(i);
+	}
+}
+
+/// writes the tree into the file, sections are only unique if deduplication is disabled
+static void write(const std::string& path, const WriteConfig& layout, bool unique) {
+	SectionManager manager {layout};
+	build(manager);
+
+	WriteConfig config;
+	config.section_deduplication = !unique;
+	manager.emit(path, config);
+}
+
+/// overwrites primitives in place, that is only allowed in files with unique sections
+static void testSet(const std::string& path, const WriteConfig& layout) {
+	write(path, layout, true);
+
+	{
+		BinaryTreeEditor editor {path};
+		auto root = editor.root().as<BinaryTreeDict>();
+
+		editor.set<BinaryTreeInt>(root.get(1), 11);
+		editor.set<BinaryTreeDouble>(root.get(2), 3.5);
+		editor.set<BinaryTreeVec3f>(root.get(3).as<BinaryTreeDict>().get(9), {4, 5, 6});
+		editor.set<BinaryTreeInt>(BinaryTreeQuery {"4/[3]"}.find(editor.root())[0], 33);
+
+		check(throws([&] () { editor.set<BinaryTreeInt>(root.get(2), 1); }), "set() with the wrong type is refused");
+		editor.sync();
+	}
+
+	check(value(path, "1") == "11", "set() an int");
+	check(value(path, "2") == "3.500000", "set() a double");
+	check(value(path, "3/9") == "4,5,6", "set() a vector");
+	check(value(path, "4/[3]") == "33", "set() an array element");
+	check(value(path, "4/[4]") == "4", "set() leaves the other elements alone");
+
+	// the sections could be shared by deduplication
+	write(path, layout, false);
+
+	{
+		BinaryTreeEditor editor {path};
+		check(throws([&] () { editor.set<BinaryTreeInt>(editor.root().as<BinaryTreeDict>().get(1), 1); }), "set() is refused without UNIQUE_SECTIONS");
+	}
+
+	// linking shares a section between two paths
+	write(path, layout, true);
+
+	{
+		BinaryTreeEditor editor {path};
+
+		editor.replace(BinaryTreeQuery {"10"}, [&] (BinaryTreeNode::Writer& writer) {
+			editor.link(writer, editor.root().as<BinaryTreeDict>().get(3));
+		});
+
+		check(throws([&] () { editor.set<BinaryTreeInt>(editor.root().as<BinaryTreeDict>().get(1), 1); }), "set() is refused after link()");
+	}
+
+	check(value(path, "10/7") == "seven", "link() shares the subtree");
+	check(value(path, "3/7") == "seven", "link() keeps the original subtree");
+
+	// versioned files have no unique sections either
+	write(path, layout, true);
+
+	{
+		BinaryTreeEditor editor {path};
+		editor.enableVersions();
+		check(throws([&] () { editor.set<BinaryTreeInt>(editor.root().as<BinaryTreeDict>().get(1), 1); }), "set() is refused in versioned files");
+	}
+}
+
+/// copies the path to each replaced value, going through every kind of container
+static void testReplace(const std::string& path, const WriteConfig& layout) {
+	write(path, layout, true);
+
+	BinaryTree::Input old {path};
+	BinaryTreeNode before = old.root();
+
+	struct Step {
+		const char* query;
+		const char* lookup;
+		const char* expected;
+		std::function<void(BinaryTreeNode::Writer&)> function;
+	};
+
+	Step steps[] = {
+		{"3/8", "3/8", "eight", [] (auto& writer) { writer.template as<BinaryTreeText>("eight"); }},
+		{"3/100", "3/100/1", "deep", [] (auto& writer) { writer.template as<BinaryTreeDict>().put(1).template as<BinaryTreeText>("deep"); }},
+		{"3/0", "3/0", "-1", [] (auto& writer) { writer.template as<BinaryTreeInt>(-1); }},
+		{"4/[9]", "4/[9]", "99", [] (auto& writer) { writer.template as<BinaryTreeInt>(99); }},
+		{"5/300", "5/300", "map", [] (auto& writer) { writer.template as<BinaryTreeText>("map"); }},
+		{"5/1", "5/1", "-5", [] (auto& writer) { writer.template as<BinaryTreeInt>(-5); }},
+		{"6/[1]/1", "6/[1]/1", "1.250000", [] (auto& writer) { writer.template as<BinaryTreeDouble>(1.25); }},
+		{"6/[2]/5", "6/[2]/5", "5", [] (auto& writer) { writer.template as<BinaryTreeInt>(5); }},
+	};
+
+	for (const Step& step : steps) {
+		{
+			BinaryTreeEditor editor {path};
+			editor.replace(BinaryTreeQuery {step.query}, step.function);
+		}
+
+		// every step leaves a valid file behind
+		check(value(path, step.lookup) == step.expected, std::string {"replace() at "} + step.query);
+	}
+
+	// the values that were not on any path are still there
+	check(value(path, "3/7") == "seven", "replace() keeps the siblings in a dict");
+	check(value(path, "4/[3]") == "3", "replace() keeps the other array elements");
+	check(value(path, "5/303") == "101", "replace() keeps the other map values");
+	check(value(path, "5/0") == "0", "replace() keeps the first map value");
+	check(value(path, "6/[2]/1") == "2", "replace() keeps the other dict in an array");
+	check(value(path, "1") == "10", "replace() keeps the root values");
+
+	// the old sections are never modified
+	auto dict = before.as<BinaryTreeDict>();
+	check((int) dict.get(3).as<BinaryTreeDict>().get(8).as<BinaryTreeInt>() == 8, "old nodes keep the old values");
+	check(!dict.get(3).as<BinaryTreeDict>().has(100), "old nodes don't see new keys");
+	check(describe(BinaryTreeQuery {"5/300"}.find(old.root())[0]) == "100", "old readers keep the old root");
+
+	// the whole tree
+	{
+		BinaryTreeEditor editor {path};
+		editor.replace(BinaryTreeQuery {""}, [] (auto& writer) { writer.template as<BinaryTreeText>("root"); });
+	}
+
+	check(value(path, "") == "root", "replace() the whole tree");
+}
+
+/// none of the failed calls modifies the file
+static void testErrors(const std::string& path, const WriteConfig& layout) {
+	write(path, layout, true);
+	uintmax_t size = std::filesystem::file_size(path);
+
+	const char* queries[] = {
+		"4/[10]", // past the end of an array
+		"9/1",    // a missing key in the middle of the path
+		"1/2",    // through a primitive
+		"*",      // not a single value
+		"[0]",    // an index in a dict
+		"5/[0]",  // an index in a map
+		"4/1",    // a key in an array
+	};
+
+	for (const char* query : queries) {
+		BinaryTreeEditor editor {path};
+		check(throws([&] () { editor.replace(BinaryTreeQuery {query}, [] (auto& writer) { writer.template as<BinaryTreeInt>(1); }); }), std::string {"replace() at "} + query + " is refused");
+	}
+
+	{
+		BinaryTreeEditor editor {path};
+		check(throws([&] () { editor.replace(BinaryTreeQuery {"4/[1]"}, [] (auto& writer) { writer.template as<BinaryTreeText>("x"); }); }), "replace() with the wrong array type is refused");
+		check(throws([&] () { editor.replace(BinaryTreeQuery {"1"}, [] (auto&) {}); }), "replace() without a value is refused");
+	}
+
+	check(std::filesystem::file_size(path) == size, "failed edits don't grow the file");
+	check(value(path, "4/[1]") == "1", "failed edits don't change the file");
+
+	// compressed files can't be edited
+	SectionManager manager;
+	build(manager);
+
+	WriteConfig config;
+	config.compression = true;
+	manager.emit(path, config);
+
+	check(throws([&] () { BinaryTreeEditor editor {path}; }), "compressed files are refused");
+}
+
+/// a file just under 4 GiB, the tail is sparse, so it doesn't take up the space
+static void testLimit(const std::string& path) {
+	write(path, {}, true);
+	std::filesystem::resize_file(path, 0xFFFFFFF0);
+
+	{
+		BinaryTreeEditor editor {path};
+		check(throws([&] () { editor.replace(BinaryTreeQuery {"1"}, [] (auto& writer) { writer.template as<BinaryTreeInt>(1); }); }), "replace() past 4 GiB is refused");
+		check(throws([&] () { editor.enableVersions(); }), "enableVersions() past 4 GiB is refused");
+	}
+
+	check(std::filesystem::file_size(path) == 0xFFFFFFF0, "the file doesn't grow past 4 GiB");
+	std::filesystem::remove(path);
+}
+
+int main() {
+	const std::string path = "test-editor.bt";
+
+	for (bool indexed : {false, true}) {
+		WriteConfig layout;
+		layout.indexed_dicts = indexed;
+
+		testSet(path, layout);
+		testReplace(path, layout);
+		testErrors(path, layout);
+	}
+
+	testLimit(path);
+	std::filesystem::remove(path);
+
+	if (failures) {
+		std::cout << failures << " checks failed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "All edits behaved as expected" << std::endl;
+	return 0;
+}
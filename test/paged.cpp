@@ -0,0 +1,236 @@
+
+#include <binary/helper.hpp>
+#include <filesystem>
+#include <random>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+	if (!condition) {
+		std::cout << "Failed: " << what << std::endl;
+		failures ++;
+	}
+}
+
+/// appends everything reachable from the node to the output, dict and map values are found by
+/// key, the iterated values only add their type, so both ways of reaching a value are used
+template <typename N>
+static void walk(N node, std::string& output) {
+	output += node.name();
+	output += ' ';
+
+	switch (node.type()) {
+		case BinaryNode::DICT: {
+			auto dict = node.template as<BinaryTreeDict>();
+
+			for (auto [key, value] : dict) {
+				output += std::to_string(key) + ":" + value.name();
+				walk(dict.get(key), output);
+			}
+
+			break;
+		}
+
+		case BinaryNode::MAP: {
+			auto map = node.template as<BinaryTreeMap>();
+
+			for (auto [key, value] : map) {
+				output += std::to_string(key) + ":" + value.name();
+				walk(map.get(key), output);
+			}
+
+			break;
+		}
+
+		case BinaryNode::LIST: {
+			for (auto value : node.template as<BinaryTreeArray<BinaryTreeNode>>()) {
+				walk(value, output);
+			}
+
+			break;
+		}
+
+		case BinaryNode::TEXT: output += node.template as<BinaryTreeText>().copy(); break;
+		case BinaryNode::INT: output += std::to_string((int) node.template as<BinaryTreeInt>()); break;
+		case BinaryNode::LONG: output += std::to_string((long) node.template as<BinaryTreeLong>()); break;
+		case BinaryNode::VEC3F: output += std::to_string(node.template as<BinaryTreeVec3f>()[2]); break;
+
+		case BinaryNode::BLOB: {
+			for (std::byte byte : node.template as<BinaryTreeBlob>().data()) {
+				output += std::to_string((int) byte) + ".";
+			}
+
+			break;
+		}
+
+		default: break;
+	}
+
+	output += ';';
+}
+
+/// walks every version of the file
+static std::string dump(BinaryTree::Input& input) {
+	std::string output;
+
+	for (uint32_t version = 0; version < input.versions(); version ++) {
+		input.select(version);
+		input.read([&] (auto root) { walk(root, output); });
+		output += '|';
+	}
+
+	return output;
+}
+
+/// writes a random tree, with values of many sizes, so that plenty of sections cross
+/// small pages, the same values are written a few times, so some sections are shared
+static void build(BinaryTreeNode::Writer writer, std::mt19937& random, int depth) {
+	int kind = depth > 2 ? 5 + random() % 5 : random() % 10;
+
+	if (kind == 0 || kind == 1) {
+		auto dict = writer.as<BinaryTreeDict>();
+		int count = random() % 12;
+
+		for (int i = 0; i < count; i ++) {
+			build(dict.put(random() % 20), random, depth + 1);
+		}
+
+		return;
+	}
+
+	if (kind == 2) {
+		auto map = writer.as<BinaryTreeMap>();
+		int count = random() % 3 == 0 ? 0 : random() % 200;
+
+		for (int i = 0; i < count; i ++) {
+			build(map.put(random() % 500), random, depth + 1);
+		}
+
+		return;
+	}
+
+	if (kind == 3) {
+		auto array = writer.as<BinaryTreeArray<BinaryTreeDict>>();
+		int count = random() % 20;
+
+		for (int i = 0; i < count; i ++) {
+			auto dict = array.put();
+			dict.put(1).as<BinaryTreeInt>(i);
+			build(dict.put(2), random, depth + 1);
+		}
+
+		return;
+	}
+
+	if (kind == 4) {
+		auto array = writer.as<BinaryTreeArray<BinaryTreeInt>>();
+		int count = random() % 100;
+
+		for (int i = 0; i < count; i ++) {
+			array.put(random() % 1000);
+		}
+
+		return;
+	}
+
+	if (kind == 5) {
+		writer.as<BinaryTreeText>(std::string(random() % 3 * 50, 'a' + random() % 3));
+		return;
+	}
+
+	if (kind == 6) {
+		std::vector<std::byte> bytes (random() % 150);
+
+		for (std::byte& byte : bytes) {
+			byte = (std::byte) random();
+		}
+
+		writer.as<BinaryTreeBlob>(std::span<const std::byte> {bytes});
+		return;
+	}
+
+	if (kind == 7) {
+		writer.as<BinaryTreeLong>(random());
+		return;
+	}
+
+	if (kind == 8) {
+		writer.as<BinaryTreeVec3f>(1, 2, random() % 10);
+		return;
+	}
+
+	writer.as<BinaryTreeInt>(random() % 10);
+}
+
+/// reads the file through the mapping, from memory, and in pages of a few sizes, all need to see the same trees
+static void compare(const std::string& path, const std::string& name) {
+	BinaryTree::Input mapped {path, true};
+	std::string expected = dump(mapped);
+
+	InputFile file {path};
+	BinaryTree::Input memory {std::span<const uint8_t> {file.data(), file.size()}, true};
+	check(dump(memory) == expected, name + " read from memory");
+
+	for (size_t page : {64, 128, 4096}) {
+		for (size_t cache : {0, 1024 * 1024}) {
+			std::string source = name + " read in pages of " + std::to_string(page) + " bytes with a cache of " + std::to_string(cache);
+
+			try {
+				BinaryTree::Input paged {path, PagedConfig {page, cache}, true};
+				check(dump(paged) == expected, source);
+			} catch (const std::runtime_error& error) {
+				check(false, source + ", " + error.what());
+			}
+		}
+	}
+}
+
+int main() {
+	const std::string path = "test-paged.bt";
+	std::mt19937 random {42};
+
+	for (int layout = 0; layout < 5; layout ++) {
+		WriteConfig config;
+		config.indexed_dicts = layout & 1;
+		config.sized_text = layout & 2;
+		config.array_alignment = layout == 4 ? 64 : 0;
+
+		std::string name = "layout " + std::to_string(layout);
+
+		for (int tree = 0; tree < 8; tree ++) {
+			SectionManager manager {config};
+			build({&manager, manager.allocate()}, random, 0);
+			manager.emit(path);
+
+			compare(path, name + " tree " + std::to_string(tree));
+		}
+
+		// each version links a subtree of the one before it
+		BinaryTreeEditor::create(path, config);
+
+		for (int version = 0; version < 10; version ++) {
+			BinaryTreeEditor editor {path};
+
+			editor.replace(BinaryTreeQuery {""}, [&] (BinaryTreeNode::Writer& writer) {
+				auto dict = writer.as<BinaryTreeDict>();
+				build(dict.put(1), random, 1);
+
+				if (version > 0) {
+					editor.link(dict.put(2), editor.root().as<BinaryTreeDict>().get(1));
+				}
+			});
+		}
+
+		compare(path, name + " versioned");
+	}
+
+	std::filesystem::remove(path);
+
+	if (failures) {
+		std::cout << failures << " checks failed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "All sources read the same trees" << std::endl;
+	return 0;
+}
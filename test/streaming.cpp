@@ -0,0 +1,136 @@
+
+#include <binary/helper.hpp>
+#include <filesystem>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+	if (!condition) {
+		std::cout << "Failed: " << what << std::endl;
+		failures ++;
+	}
+}
+
+/// returns true if the function throws a runtime error
+template <typename F>
+static bool throws(F function) {
+	try {
+		function();
+	} catch (const std::runtime_error&) {
+		return true;
+	}
+
+	return false;
+}
+
+/// describes the tree written by build(), the sections are laid out in a different order
+/// when streaming, so the files are compared by what they contain
+static std::string dump(BinaryTreeNode node) {
+	std::string output;
+	auto root = node.as<BinaryTreeDict>();
+
+	for (auto entity : root.get(1).as<BinaryTreeArray<BinaryTreeDict>>()) {
+		output += entity.get(1).as<BinaryTreeText>().copy() + ":";
+
+		for (auto [key, value] : entity.get(2).as<BinaryTreeMap>()) {
+			output += std::to_string(key) + "=" + std::to_string((int) value.as<BinaryTreeInt>()) + ",";
+		}
+
+		output += ";";
+	}
+
+	return output + std::to_string((int) root.get(2).as<BinaryTreeInt>());
+}
+
+/// writes a tree with repeated subtrees, closing every container as soon as it is complete
+static void build(SectionManager& manager) {
+	BinaryTreeNode::Writer root {&manager, manager.allocate()};
+	auto dict = root.as<BinaryTreeDict>();
+	auto entities = dict.put(1).as<BinaryTreeArray<BinaryTreeDict>>();
+
+	for (int i = 0; i < 2000; i ++) {
+		auto entity = entities.put();
+		entity.put(1).as<BinaryTreeText>(i % 3 ? "common" : "rare");
+
+		auto values = entity.put(2).as<BinaryTreeMap>();
+
+		for (int j = 0; j < i % 5; j ++) {
+			values.put(j * 7).as<BinaryTreeInt>(j);
+		}
+
+		values.close();
+		entity.close();
+	}
+
+	entities.close();
+	dict.put(2).as<BinaryTreeInt>(42);
+}
+
+int main() {
+	const std::string path = "test-streaming.bt";
+
+	// the streamed file needs to hold the same tree as the one written all at once
+	for (bool deduplication : {false, true}) {
+		WriteConfig config;
+		config.section_deduplication = deduplication;
+
+		SectionManager memory;
+		build(memory);
+		memory.emit(path, config);
+
+		BinaryTree::Input buffered {path, true};
+		std::string expected = dump(buffered.root());
+
+		{
+			OutputFile output {path};
+			SectionManager manager {output, config};
+			build(manager);
+			manager.finish();
+			output.commit();
+		}
+
+		BinaryTree::Input streamed {path, true};
+		check(dump(streamed.root()) == expected, std::string {"streamed output with deduplication "} + (deduplication ? "enabled" : "disabled"));
+	}
+
+	// closed sections are released, so using them again has to fail instead of writing into reused memory
+	{
+		OutputFile output {path};
+		SectionManager manager {output};
+
+		BinaryTreeNode::Writer root {&manager, manager.allocate()};
+		auto dict = root.as<BinaryTreeDict>();
+
+		auto closed = dict.put(1).as<BinaryTreeDict>();
+		auto child = closed.put(1).as<BinaryTreeArray<BinaryTreeInt>>();
+		child.put(1);
+		closed.close();
+
+		check(throws([&] () { closed.close(); }), "closing a section twice is refused");
+		check(throws([&] () { closed.put(2).as<BinaryTreeInt>(2); }), "writing into a closed section is refused");
+		check(throws([&] () { child.put(2); }), "writing into the child of a closed section is refused");
+		check(throws([&] () { child.close(); }), "closing the child of a closed section is refused");
+
+		// the rest of the tree can still be written
+		dict.put(2).as<BinaryTreeInt>(2);
+		manager.finish();
+		output.commit();
+
+		check(throws([&] () { dict.put(3).as<BinaryTreeInt>(3); }), "writing into the root after finish() is refused");
+	}
+
+	BinaryTree::Input input {path, true};
+	auto root = input.root().as<BinaryTreeDict>();
+	check((int) root.get(1).as<BinaryTreeDict>().get(1).as<BinaryTreeArray<BinaryTreeInt>>().at(0) == 1, "the closed section was written");
+	check((int) root.get(2).as<BinaryTreeInt>() == 2, "the tree is complete after the refused writes");
+
+	std::filesystem::remove(path);
+
+	if (failures) {
+		std::cout << failures << " checks failed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "Streaming matched the buffered output" << std::endl;
+	return 0;
+}
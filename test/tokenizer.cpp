@@ -0,0 +1,285 @@
+
+#include <text/token.hpp>
+#include <random>
+
+// the tokenizer as it was before the input was classified in blocks, it
+// steps through every byte, the block tokenizer has to produce the same tokens
+namespace reference {
+
+	static bool isWhite(char chr) {
+		return chr == ' ' || chr == '\n' || chr == '\t' || chr == '\r';
+	}
+
+	static bool isSymbol(char chr) {
+		return chr == '[' || chr == ']' || chr == '{' || chr == '}' || chr == ',';
+	}
+
+	static bool isPrintable(char chr) {
+		return chr >= ' ' && chr <= '~';
+	}
+
+	static bool isWord(char chr) {
+		return (chr >= '0' && chr <= '9') || (chr >= 'a' && chr <= 'z') || (chr >= 'A' && chr <= 'Z') || chr == '_' || chr == '-' || chr == '.';
+	}
+
+	static std::string identify(char chr) {
+		if (chr >= ' ' && chr <= '~') {
+			return std::string("'") + chr + "'";
+		}
+
+		if (chr == '\0') return "nul byte (\'\\0\')";
+		if (chr == '\n') return "new line (\'\\n\')";
+		if (chr == '\t') return "tab (\'\\t\')";
+		if (chr == '\r') return "carriage return (\'\\n\')";
+
+		return "ascii+" + std::to_string((int) chr);
+	}
+
+	static std::vector<Token> tokenize(const char* start, int size) {
+
+		std::vector<Token> tokens;
+
+		enum {
+			OUTER,
+			WORD,
+			STRING,
+			COMMENT
+		} state = OUTER;
+
+		int last = size - 1;
+		int line = 1;
+		int column = 1;
+		int begin = 0;
+
+		for (int i = 0; i < size; i ++) {
+
+			char c = *(start + i);
+			char n = (i == last) ? 0 : *(start + i + 1);
+
+			if (c == '\n') {
+				line ++;
+				column = 1;
+			} else {
+				column ++;
+			}
+
+			if (state == OUTER) {
+
+				if (c == '/' && n == '*') {
+					state = COMMENT;
+					i ++;
+					column ++;
+					continue;
+				}
+
+				if (c == '"') {
+					begin = i + 1;
+					state = STRING;
+					continue;
+				}
+
+				if (isWord(n)) {
+					begin = i + 1;
+					state = WORD;
+					continue;
+				}
+
+				if (isSymbol(c)) {
+					tokens.emplace_back(start + i, 1, Token::SYMBOL, line, column);
+					continue;
+				}
+
+				if (isWhite(c)) {
+					continue;
+				}
+
+				throw ParseError {"Unexpected " + identify(c) + " in scope", line, column};
+
+			}
+
+			if (state == WORD) {
+
+				if (isWhite(n) || isSymbol(n)) {
+					tokens.emplace_back(start + begin, i - begin + 1, Token::WORD, line, column);
+					state = OUTER;
+					continue;
+				}
+
+				if (isWord(n)) {
+					continue;
+				}
+
+				throw ParseError {"Unexpected " + identify(n) + " in token", line, column};
+
+			}
+
+			if (state == COMMENT) {
+
+				if (c == '*' && n == '/') {
+					state = OUTER;
+					i ++;
+					column ++;
+				}
+
+				continue;
+
+			}
+
+			if (state == STRING) {
+
+				if (c == '\\') {
+
+					if (!isPrintable(n)) {
+						throw ParseError {"Unexpected " + identify(n) + " in escape", line, column + 1};
+					}
+
+					i ++;
+					column ++;
+					continue;
+				}
+
+				if (c == '"') {
+					tokens.emplace_back(start + begin, i - begin, Token::STRING, line, column);
+					state = OUTER;
+					continue;
+				}
+
+				if (c != '\n' && c != '\0') {
+					continue;
+				}
+
+				throw ParseError {"Unexpected " + identify(c) + " in string", line, column};
+
+			}
+
+		}
+
+		// each kind of bracket is matched on its own, unmatched ones keep -1
+		std::vector<int> squares;
+		std::vector<int> curlies;
+
+		for (int i = 0; i < (int) tokens.size(); i ++) {
+			Token& token = tokens[i];
+
+			if (token.type != Token::SYMBOL) {
+				continue;
+			}
+
+			char c = *token.start;
+
+			if (c == '[') squares.push_back(i);
+			if (c == '{') curlies.push_back(i);
+
+			std::vector<int>& open = (c == ']') ? squares : curlies;
+
+			if ((c == ']' || c == '}') && !open.empty()) {
+				tokens[open.back()].match = i;
+				open.pop_back();
+			}
+		}
+
+		return tokens;
+
+	}
+
+}
+
+/// describes all the tokens, or the error, in a way that can be compared
+template <typename F>
+static std::string describe(const std::string& input, F tokenize) {
+	std::string result;
+
+	try {
+		for (const Token& token : tokenize(input.data(), (int) input.size())) {
+			result += std::string(token.name()) + " " + std::to_string(token.start - input.data()) + " " + std::to_string(token.end - token.start) + " ";
+			result += std::to_string(token.line) + ":" + std::to_string(token.column) + " " + std::to_string(token.match) + "\n";
+		}
+	} catch (const ParseError& error) {
+		result += "error '" + error.message + "' " + std::to_string(error.line) + ":" + std::to_string(error.column) + "\n";
+	}
+
+	return result;
+}
+
+/// checks the masks against the definition of each class, one byte at a time
+static bool classified(TokenMasks::Classifier classify, const uint8_t* block) {
+	TokenMasks masks = classify((const char*) block);
+
+	for (int i = 0; i < 64; i ++) {
+		char chr = block[i];
+		auto bit = [&] (uint64_t mask) { return (bool) ((mask >> i) & 1); };
+
+		bool expected[] = {reference::isWord(chr), reference::isWhite(chr), chr == '"', chr == '\\', chr == '\n', chr == '\0', chr == '*', chr == '/'};
+		bool actual[] = {bit(masks.word), bit(masks.white), bit(masks.quote), bit(masks.backslash), bit(masks.newline), bit(masks.nul), bit(masks.star), bit(masks.slash)};
+
+		if (!std::equal(std::begin(expected), std::end(expected), std::begin(actual))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv) {
+
+	if (argc < 2) {
+		std::cout << "Usage: test-tokenizer avx2|sse2|scalar" << std::endl;
+		return 1;
+	}
+
+	// the implementation is requested with LIB_FORMAT_CLASSIFIER, the test is skipped if it isn't available here
+	std::string name = argv[1];
+	TokenMasks::Classifier classify = TokenMasks::classifier(name);
+
+	if (!classify) {
+		std::cout << "The " << name << " classifier is not supported by this build or CPU" << std::endl;
+		return 77;
+	}
+
+	if (TokenMasks::implementation() != name) {
+		std::cout << "Expected the tokenizer to use " << name << " but it uses " << TokenMasks::implementation() << std::endl;
+		return 1;
+	}
+
+	std::mt19937 random {1234};
+
+	// every byte value, in every position of the block
+	for (int i = 0; i < 4096; i ++) {
+		uint8_t block[64];
+
+		for (uint8_t& byte : block) {
+			byte = random();
+		}
+
+		if (!classified(classify, block)) {
+			std::cout << "The " << name << " classifier disagrees with the character classes" << std::endl;
+			return 1;
+		}
+	}
+
+	// short inputs end within the first blocks, a few longer ones cross many of them
+	const std::string pieces[] = {
+		" ", "\n", "\t", "\r", "{", "}", "[", "]", ",", "\"", "\\", "/*", "*/", "*", "/", "abc", "x", "1.5", "-", "_",
+		std::string(1, '\0'), "@", "\x80", "\xff", "\"str\"", "\\\"", "/* c\n */", std::string(70, ' '), std::string(64, 'w')
+	};
+
+	for (int i = 0; i < 20000; i ++) {
+		std::string input;
+		int length = random() % (i % 10 == 0 ? 400 : 40);
+
+		for (int j = 0; j < length; j ++) {
+			input += pieces[random() % std::size(pieces)];
+		}
+
+		std::string expected = describe(input, reference::tokenize);
+		std::string actual = describe(input, Token::tokenize);
+
+		if (expected != actual) {
+			std::cout << "Tokens differ for input " << i << " of " << input.size() << " bytes, expected:\n" << expected << "but got:\n" << actual << std::endl;
+			return 1;
+		}
+	}
+
+	std::cout << "The " << name << " tokenizer matches the reference" << std::endl;
+	return 0;
+}
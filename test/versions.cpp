@@ -0,0 +1,163 @@
+
+#include <binary/helper.hpp>
+#include <filesystem>
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+	if (!condition) {
+		std::cout << "Failed: " << what << std::endl;
+		failures ++;
+	}
+}
+
+/// returns true if the function throws a runtime error
+template <typename F>
+static bool throws(F function) {
+	try {
+		function();
+	} catch (const std::runtime_error&) {
+		return true;
+	}
+
+	return false;
+}
+
+/// checks the values the version was written with, the array is shared by all versions
+static bool matches(BinaryTreeNode root, uint32_t version) {
+	auto dict = root.as<BinaryTreeDict>();
+	auto shared = dict.get(2).as<BinaryTreeArray<BinaryTreeInt>>();
+
+	return (int) dict.get(1).as<BinaryTreeInt>() == (int) version
+		&& dict.get(3).as<BinaryTreeText>().copy() == "v" + std::to_string(version)
+		&& shared.size() == 100 && (int) shared.at(99) == 99;
+}
+
+/// checks every version through a reader that validates the whole file, including the older version tables
+static void verify(const std::string& path, uint32_t versions) {
+	BinaryTree::Input input {path, true};
+	check(input.versions() == versions, "the file has " + std::to_string(versions) + " versions");
+
+	for (uint32_t version = 0; version < versions; version ++) {
+		input.select(version);
+		check(matches(input.root(), version), "version " + std::to_string(version) + " of " + std::to_string(versions));
+	}
+
+	check(throws([&] () { input.select(versions); }), "versions past the last one are refused");
+}
+
+/// each version is a whole new tree, that links the array of the one before it
+static void testCreate(const std::string& path, const WriteConfig& layout) {
+	BinaryTreeEditor::create(path, layout);
+
+	// the versions span three table sections, the checks are repeated around the capacity
+	const uint32_t total = BinaryTreeVersions::capacity * 2 + 10;
+
+	for (uint32_t version = 0; version < total; version ++) {
+		{
+			BinaryTreeEditor editor {path};
+
+			editor.replace(BinaryTreeQuery {""}, [&] (BinaryTreeNode::Writer& writer) {
+				auto dict = writer.as<BinaryTreeDict>();
+				dict.put(1).as<BinaryTreeInt>(version);
+
+				if (version == 0) {
+					auto shared = dict.put(2).as<BinaryTreeArray<BinaryTreeInt>>();
+
+					for (int i = 0; i < 100; i ++) {
+						shared.put(i);
+					}
+				} else {
+					editor.link(dict.put(2), editor.root().as<BinaryTreeDict>().get(2));
+				}
+
+				dict.put(3).as<BinaryTreeText>("v" + std::to_string(version));
+			});
+
+			check(editor.versions() == version + 1, "the editor counts the new version");
+			check(matches(editor.root(version / 2), version / 2), "the editor reads older versions");
+		}
+
+		uint32_t count = version + 1;
+		uint32_t position = count % BinaryTreeVersions::capacity;
+
+		if (count < 4 || position <= 1 || position == BinaryTreeVersions::capacity - 1) {
+			verify(path, count);
+		}
+	}
+
+	verify(path, total);
+}
+
+/// an existing file becomes the first version, the rest change a single value each
+static void testEnable(const std::string& path, const WriteConfig& layout) {
+	SectionManager manager {layout};
+	BinaryTreeNode::Writer root {&manager, manager.allocate()};
+
+	auto dict = root.as<BinaryTreeDict>();
+	dict.put(1).as<BinaryTreeInt>(0);
+
+	auto shared = dict.put(2).as<BinaryTreeArray<BinaryTreeInt>>();
+
+	for (int i = 0; i < 100; i ++) {
+		shared.put(i);
+	}
+
+	dict.put(3).as<BinaryTreeText>("v0");
+	manager.emit(path);
+
+	{
+		BinaryTreeEditor editor {path};
+		editor.enableVersions();
+		editor.enableVersions();
+	}
+
+	verify(path, 1);
+
+	// only the root dict is copied, the array and the text of the first version stay shared
+	const uint32_t total = BinaryTreeVersions::capacity + 6;
+
+	for (uint32_t version = 1; version < total; version ++) {
+		BinaryTreeEditor editor {path};
+
+		editor.replace(BinaryTreeQuery {"1"}, [&] (BinaryTreeNode::Writer& writer) {
+			writer.as<BinaryTreeInt>(version);
+		});
+
+		editor.replace(BinaryTreeQuery {"3"}, [&] (BinaryTreeNode::Writer& writer) {
+			writer.as<BinaryTreeText>("v" + std::to_string(version));
+		});
+	}
+
+	// every version but the first has an intermediate one between it and the previous,
+	// that has the new number with the old text, so these are skipped when checking
+	BinaryTree::Input input {path, true};
+	check(input.versions() == total * 2 - 1, "each replace() adds a version");
+
+	for (uint32_t version = 0; version < total; version ++) {
+		input.select(version * 2);
+		check(matches(input.root(), version), "version " + std::to_string(version) + " after enableVersions()");
+	}
+}
+
+int main() {
+	const std::string path = "test-versions.bt";
+
+	for (bool indexed : {false, true}) {
+		WriteConfig layout;
+		layout.indexed_dicts = indexed;
+
+		testCreate(path, layout);
+		testEnable(path, layout);
+	}
+
+	std::filesystem::remove(path);
+
+	if (failures) {
+		std::cout << failures << " checks failed" << std::endl;
+		return 1;
+	}
+
+	std::cout << "All versions matched" << std::endl;
+	return 0;
+}